@@ -8,6 +8,20 @@
 #include <string>    // for string manipulation
 #include <unordered_map>  // for hash maps (fast key-value lookups)
 #include <list>      // for linked lists (used for memory block management)
+#include <map>       // for ordered maps (used for the pending job queue)
+#include <set>       // for ordered sets (used to index pending jobs by size)
+#include <climits>   // for INT_MAX (used for processes without a deadline)
+#include <deque>     // for the sliding window of recent cpu bursts
+#include <algorithm> // for nth_element (used to find a burst percentile)
+#include <cstdlib>   // for atoi (used when reading command line flags)
+#include <cstdio>    // for sscanf (used when reading command line flags) and remove
+#include <chrono>    // for timing allocator calls in the benchmark
+#include <sstream>   // for splitting comma separated flag values
+#include <fstream>   // for the swap file (backing store for swapped out processes)
+#include <random>    // for the arrival time generators
+#ifdef __AVX2__
+#include <immintrin.h> // for 256 bit scans of the bitmap allocator (build with -mavx2)
+#endif
 using namespace std;
 
 // define process states as an enum for better type safety
@@ -26,7 +40,8 @@ enum InstructionType {
     COMPUTE = 1, // performs a computational task for a specific number of cycles
     PRINT = 2,   // performs an IO operation (printing) for a specific number of cycles
     STORE = 3,   // stores a value at a specific memory address
-    LOAD = 4     // loads a value from a specific memory address
+    LOAD = 4,    // loads a value from a specific memory address
+    FORK = 5     // starts a child process that continues after the FORK
 };
 
 // structure to represent an instruction
@@ -51,6 +66,7 @@ struct MemoryBlock {
     // this allows us to create a new block with one line of code
     MemoryBlock(int id, int start, int sz) : 
         processID(id), startAddress(start), size(sz) {}
+    MemoryBlock() : processID(-1), startAddress(0), size(0) {}
 };
 
 // process control block (PCB) structure
@@ -68,333 +84,5044 @@ struct PCB {
     int mainMemoryBase;  // starting address of the process in main memory
     vector<Instruction> instructions;  // list of instructions for this process
     int paramOffset;     // keeps track of the current parameter offset during execution
+    int tableRow;        // row of this process in the process table (not stored in memory)
     
     // constructor with default initialization
     // this sets up a new PCB with safe default values
     PCB() : processID(0), state(STATE_NEW), programCounter(0), 
             instructionBase(0), dataBase(0), memoryLimit(0),
             cpuCyclesUsed(0), registerValue(0), maxMemoryNeeded(0), 
-            mainMemoryBase(0), paramOffset(0) {}
+            mainMemoryBase(0), paramOffset(0), tableRow(-1) {}
 };
 
 // custom structure for tracking IO waiting processes
 // this holds information about a process that's waiting for IO to complete
 struct IOWaitItem {
-    int pcbAddress;       // memory address where the PCB is stored
+    int pcbAddress;       // memory address where the PCB is stored (-1 while swapped out)
     int waitDuration;     // how long this IO operation should take
     int entryTime;        // when the process started waiting for IO
+    int processID;        // which process is waiting (needed once it is swapped out)
+    int tableRow;         // its row in the process table
+    bool pageFault;       // waiting for pages to come in, not for a PRINT
     
     // constructor for easier initialization
     // this creates a new IO wait record with one line of code
-    IOWaitItem(int address, int duration, int time) :
-        pcbAddress(address), waitDuration(duration), entryTime(time) {}
+    IOWaitItem(int address, int duration, int time, int id, int row, bool fault = false) :
+        pcbAddress(address), waitDuration(duration), entryTime(time), processID(id), tableRow(row),
+        pageFault(fault) {}
 };
 
-// global memory management linked list
-// this keeps track of all memory blocks (free and allocated)
-list<MemoryBlock> memoryBlocks;
+// where a swapped out process image lives in the backing store
+struct SwapRecord {
+    long long fileOffset; // offset of the image in the swap file, in words
+    int size;             // image size in words (maxMemoryNeeded + 10)
+    int oldAddress;       // address the image was swapped out from
+};
+
+// queue of jobs waiting to be loaded into memory
+// jobs are kept in arrival order and also indexed by the memory they need
+// (maxMemoryNeeded + 10): a segment tree over the arrival sequence holds
+// the smallest need below each node, so the earliest job that fits a hole
+// is found in O(log n) instead of by walking the backlog. when most leaves
+// belong to jobs that already left, the waiting jobs are renumbered from 0
+// and the tree is rebuilt, so it stays proportional to the jobs waiting
+struct PendingJobQueue {
+    map<long long, PCB> byArrival;         // arrival sequence -> job
+    vector<int> minNeed;                   // segment tree over arrival sequences (leaf i at
+                                           // leaves + i); INT_MAX where there is no job
+    long long leaves;                      // sequences the tree covers (a power of two)
+    long long nextSequence;                // sequence number for the next job pushed
+
+    PendingJobQueue() : minNeed(2, INT_MAX), leaves(1), nextSequence(0) {}
+
+    bool empty() const { return byArrival.empty(); }
+    size_t size() const { return byArrival.size(); }
+
+    // adds a job at the back of the queue
+    void push(const PCB& job) {
+        setNeed(nextSequence, job.maxMemoryNeeded + 10);
+        byArrival.insert(make_pair(nextSequence, job));
+        nextSequence++;
+    }
+
+    // the job that arrived first
+    PCB& front() { return byArrival.begin()->second; }
+    long long frontSequence() const { return byArrival.begin()->first; }
+
+    // looks up a job by its arrival sequence
+    PCB& at(long long sequence) { return byArrival.find(sequence)->second; }
+
+    // removes a job by its arrival sequence
+    // (this may renumber the jobs still waiting)
+    void erase(long long sequence) {
+        setNeed(sequence, INT_MAX);
+        byArrival.erase(sequence);
+        if (leaves > 64 && leaves > 4 * static_cast<long long>(byArrival.size())) {
+            renumber();
+        }
+    }
+    void pop_front() { erase(frontSequence()); }
+
+    // finds the earliest job needing at most 'limit' words, skipping one
+    // sequence (the blocked head)
+    long long earliestFitting(int limit, long long skipSequence) const {
+        long long found = leftmostFitting(1, 0, leaves, 0, limit);
+        if (found == skipSequence) {
+            found = leftmostFitting(1, 0, leaves, skipSequence + 1, limit);
+        }
+        return found;
+    }
+
+private:
+    // writes a leaf and updates the minimums above it
+    void setNeed(long long sequence, int need) {
+        while (sequence >= leaves) {
+            grow();
+        }
+        long long node = leaves + sequence;
+        minNeed[node] = need;
+        for (node /= 2; node >= 1; node /= 2) {
+            minNeed[node] = min(minNeed[2 * node], minNeed[2 * node + 1]);
+        }
+    }
+
+    // gives the waiting jobs sequences 0, 1, ... in arrival order and
+    // rebuilds the tree for twice that many
+    void renumber() {
+        map<long long, PCB> renumbered;
+        nextSequence = 0;
+        for (map<long long, PCB>::iterator it = byArrival.begin(); it != byArrival.end(); ++it) {
+            PCB& job = renumbered.insert(renumbered.end(), make_pair(nextSequence++, PCB()))->second;
+            swap(job, it->second);
+        }
+        byArrival.swap(renumbered);
+        leaves = 1;
+        while (leaves < 2 * nextSequence) {
+            leaves *= 2;
+        }
+        minNeed.assign(2 * leaves, INT_MAX);
+        for (map<long long, PCB>::iterator it = byArrival.begin(); it != byArrival.end(); ++it) {
+            minNeed[leaves + it->first] = it->second.maxMemoryNeeded + 10;
+        }
+        for (long long node = leaves - 1; node >= 1; node--) {
+            minNeed[node] = min(minNeed[2 * node], minNeed[2 * node + 1]);
+        }
+    }
+
+    // doubles the sequences the tree covers
+    void grow() {
+        vector<int> wider(4 * leaves, INT_MAX);
+        copy(minNeed.begin() + leaves, minNeed.end(), wider.begin() + 2 * leaves);
+        leaves *= 2;
+        for (long long node = leaves - 1; node >= 1; node--) {
+            wider[node] = min(wider[2 * node], wider[2 * node + 1]);
+        }
+        minNeed.swap(wider);
+    }
+
+    // the lowest sequence at or after 'from' under 'node' (which covers
+    // [low, high)) whose job needs at most 'limit' words, or -1; a subtree
+    // whose minimum is too big is never entered
+    long long leftmostFitting(long long node, long long low, long long high, long long from, int limit) const {
+        if (high <= from || minNeed[node] > limit) {
+            return -1;
+        }
+        if (high - low == 1) {
+            return low;
+        }
+        long long middle = (low + high) / 2;
+        long long found = leftmostFitting(2 * node, low, middle, from, limit);
+        return (found != -1) ? found : leftmostFitting(2 * node + 1, middle, high, from, limit);
+    }
+};
+
+// how many process records have not been read from the input yet
+int processesToRead = 0;
+
+// jobs that have been read but whose arrival time is still in the future
+// ordered by arrival time; jobs with equal times keep their input order
+multimap<int, PCB> futureArrivals;
+
+// global variables
+int globalClock = 0;           // tracks the current system time
+bool timeoutOccurred = false;  // indicates if a process timed out
+bool memoryFreed = false;      // indicates if memory was freed during execution
+int contextSwitchTime;         // time required to switch between processes
+int CPUAllocated;              // maximum CPU time a process can use before timeout
+queue<IOWaitItem> ioWaitingQueue; // queue of processes waiting for IO
+
+// simulator options, set from command line flags in main()
+// the defaults reproduce the original round robin behaviour exactly
+bool readDeadlines = false;        // each process record carries a relative deadline
+string schedulingPolicy = "rr";    // "rr" (round robin) or "edf" (earliest deadline first)
+bool adaptiveQuantum = false;      // adjust CPUAllocated from observed cpu bursts
+int quantumPercentile = 80;        // burst percentile the adaptive quantum aims for
+int quantumMin = 1;                // smallest quantum the adaptive mode may choose
+int quantumMax = INT_MAX;          // largest quantum the adaptive mode may choose
+int quantumWindow = 32;            // how many recent bursts the adaptive mode looks at
+bool tieredSwitchCost = false;     // charge context switches by how warm the process is
+int redispatchSwitchCost = 0;      // cost when the same process runs again right away
+int warmSwitchCost = -1;           // cost for a recently run process (-1: half of contextSwitchTime)
+int coldSwitchCost = -1;           // cost for any other process (-1: contextSwitchTime)
+int warmSwitchWindow = 3;          // a process is warm if at most this many other dispatches ran since
+bool backfillAdmission = false;    // admit later jobs that fit when the head job does not
+int backfillLimit = 0;             // bypasses before the blocked head reserves memory (0: no limit)
+bool swappingEnabled = false;      // swap out IO waiting processes to admit new jobs
+bool compactionEnabled = false;    // slide processes together when no single hole fits a job
+int idleCompactBudget = 0;         // words the idle compactor may move per idle time unit (0: off)
+bool lazyScrub = false;            // tag freed memory instead of writing -1 into every word
+int pageSize = 0;                  // paged memory: words per page and frame (0: contiguous blocks)
+int tlbEntries = 0;                // paged memory: TLB size in entries (0: no TLB)
+int tlbWays = 0;                   // TLB associativity (0: fully associative)
+string tlbPolicy = "lru";          // TLB replacement: "lru", "fifo" or "random"
+bool tlbASIDs = false;             // tag TLB entries with the process instead of flushing on a switch
+int tlbMissCycles = 10;            // time charged on globalClock for each TLB miss
+string demandPolicy;               // demand paging page replacement ("" = every page resident)
+int pageFaultTime = 20;            // demand paging: IO wait per page read or written for a fault
+string pageFileName = "pagefile.bin"; // demand paging: backing store for pages
+bool keepPageFile = false;         // the page file was named with --page-file, so it stays after the run
+bool loadControl = false;          // demand paging: keep the working sets of active processes within memory
+int workingSetWindow = 64;         // demand paging: page references a working set looks back over
+bool segmentedMemory = false;      // separate code and data segments, identical code is shared
+int swapAfter = 10;                // IO wait time before a process may be swapped out
+string swapFileName = "swapfile.bin"; // backing store used by the swapper
+bool keepSwapFile = false;         // the swap file was named with --swap-file, so it stays after the run
+string arrivalMode = "none";       // "none" (all at 0), "input", "poisson", "bursty" or "periodic"
+double arrivalGap = 10.0;          // mean (poisson, bursty) or exact (periodic) gap between arrivals
+int burstOnTime = 100;             // bursty mode: length of an on period
+int burstOffTime = 100;            // bursty mode: length of an off period
+unsigned int arrivalSeed = 1;      // seed for the random arrival generators
+bool streamingInput = false;       // read process records lazily instead of all up front
+int streamWindow = 1;              // streaming mode: how many read jobs may wait for memory
+string allocatorName = "first-fit"; // memory allocator backend (see createAllocator)
+bool placementCheck = false;       // flag loads placed differently from first fit
+string benchmarkList;              // allocators to benchmark instead of simulating ("" = simulate)
+vector<int> benchMemorySizes(1, 65536); // benchmark: simulated memory sizes in words (one run each)
+int benchJobs = 100000;            // benchmark: number of jobs in the workload
+int benchMinSize = 64;             // benchmark: smallest job size in words
+int benchMaxSize = 2048;           // benchmark: largest job size in words
+int benchMinLife = 20;             // benchmark: shortest job lifetime in ticks
+int benchMaxLife = 200;            // benchmark: longest job lifetime in ticks
+unsigned int benchSeed = 1;        // benchmark: seed for the workload
+string benchTraceName;             // benchmark: replay this allocation trace instead ("" = synthetic)
+string traceFileName;              // write an allocation trace of the run here ("" = off)
+string fragmentationFileName;      // write the fragmentation time series here ("" = off)
+int fragmentationEvery = 100;      // time units between fragmentation samples
+bool printStats = false;           // print the scheduling report even in the default modes
+
+// deadline of a process, kept both as given in the input and on the clock
+struct ProcessDeadline {
+    int relative; // deadline as read from the input (cycles after arrival)
+    int absolute; // globalClock value the process should terminate by
+};
+
+// demand paging: the pages a process referenced in its last
+// workingSetWindow page references (page 0 is pinned and always counted)
+struct WorkingSet {
+    vector<int> window;    // the last references, as a ring
+    vector<int> pageCount; // references to each page inside the window
+    int next;              // ring position the next reference goes to
+    int filled;            // references in the window (it is full at workingSetWindow)
+    int size;              // distinct pages in the window, plus page 0
+
+    WorkingSet() : next(0), filled(0), size(1) {}
+};
+
+// segmented memory: one segment of a process image
+struct Segment {
+    int base;  // physical address of the first word (-1 if there is none)
+    int limit; // words in the segment
+
+    Segment() : base(-1), limit(0) {}
+};
+
+// segmented memory: the two segments of a process
+// the code segment holds the opcodes and parameters, the data segment the
+// PCB and every word after the code
+struct SegmentTable {
+    Segment code;
+    Segment data;
+};
+
+// dense process table
+// input PIDs can be any numbers, so each process gets a small row number
+// when its record is read and keeps it until it terminates (then the row is
+// reused). per process data lives in parallel arrays indexed by the row, and
+// the row of a loaded process is found from its PCB address, so dispatch
+// and IO completion never hash a PID
+struct ProcessTable {
+    vector<int> processID;
+    vector<int> arrivalTime;         // 0 for processes present from the start
+    vector<int> startTime;           // when the process first entered the running state (-1 before)
+    vector<ProcessDeadline> deadline; // relative is 0 if the process has no deadline
+    vector<int> burstCycles;         // cycles of the cpu burst in progress
+    vector<int> lastDispatch;        // dispatch number at which the process last ran (-1 never)
+    vector<MemoryBlock> block;       // memory block (processID -1 while not in memory)
+    vector<SwapRecord> swapRecord;   // where the image is while swapped out
+    vector<int> programCounter;      // hot PCB fields as of the last savePCBToMemory;
+    vector<int> paramOffset;         // paramOffset is not stored in the PCB words, so this
+    vector<int> cpuCyclesUsed;       // spares the rescan of executed instructions
+    vector<char> opcodesRewritten;   // a STORE hit an executed opcode, so always rescan
+    vector<vector<int> > pageTable;  // paged memory: frame number of each page of the image
+                                     // (-1 while the page is not resident)
+    vector<vector<int> > pageSlot;   // demand paging: page file slot of each page (-1: none yet)
+    vector<vector<int> > lockedFrames; // demand paging: frames kept for the next instruction
+    vector<WorkingSet> workingSet;   // demand paging: recently referenced pages
+    vector<SegmentTable> segments;   // segmented memory: where the image is
+    vector<vector<int> > codeImage;  // segmented memory: opcodes and parameters of a job not
+                                     // loaded yet, to find an identical code segment
+    vector<long long> tlbHits;       // TLB lookups by this process that hit
+    vector<long long> tlbMisses;     // and that missed
+    vector<int> freeRows;            // rows of terminated processes, reused first
+    unordered_map<int, int> rowAtAddress; // PCB address -> row, for the live processes only
+
+    // gives a newly read process a row
+    int addRow(int id) {
+        int row;
+        if (!freeRows.empty()) {
+            row = freeRows.back();
+            freeRows.pop_back();
+        } else {
+            row = processID.size();
+            processID.push_back(0);
+            arrivalTime.push_back(0);
+            startTime.push_back(0);
+            deadline.push_back(ProcessDeadline());
+            burstCycles.push_back(0);
+            lastDispatch.push_back(0);
+            block.push_back(MemoryBlock());
+            swapRecord.push_back(SwapRecord());
+            programCounter.push_back(0);
+            paramOffset.push_back(0);
+            cpuCyclesUsed.push_back(0);
+            opcodesRewritten.push_back(0);
+            pageTable.push_back(vector<int>());
+            pageSlot.push_back(vector<int>());
+            lockedFrames.push_back(vector<int>());
+            workingSet.push_back(WorkingSet());
+            segments.push_back(SegmentTable());
+            codeImage.push_back(vector<int>());
+            tlbHits.push_back(0);
+            tlbMisses.push_back(0);
+        }
+        processID[row] = id;
+        arrivalTime[row] = 0;
+        startTime[row] = -1;
+        deadline[row].relative = 0;
+        deadline[row].absolute = INT_MAX;
+        burstCycles[row] = 0;
+        lastDispatch[row] = -1;
+        block[row] = MemoryBlock();
+        programCounter[row] = -1; // nothing cached yet
+        paramOffset[row] = 0;
+        cpuCyclesUsed[row] = 0;
+        opcodesRewritten[row] = 0;
+        pageTable[row].clear();
+        pageSlot[row].clear();
+        lockedFrames[row].clear();
+        workingSet[row] = WorkingSet();
+        segments[row] = SegmentTable();
+        codeImage[row].clear();
+        tlbHits[row] = 0;
+        tlbMisses[row] = 0;
+        return row;
+    }
+
+    // hands the row of a terminated process back
+    void releaseRow(int row) {
+        freeRows.push_back(row);
+    }
+
+    // finds the row of the process whose PCB starts at an address (-1 if none)
+    int rowAt(int address) const {
+        unordered_map<int, int>::const_iterator it = rowAtAddress.find(address);
+        return (it != rowAtAddress.end()) ? it->second : -1;
+    }
+
+    // points a process's block at a new start address
+    void moveBlock(int row, int newAddress) {
+        if (rowAt(block[row].startAddress) == row) {
+            rowAtAddress.erase(block[row].startAddress);
+        }
+        block[row].startAddress = newAddress;
+        rowAtAddress[newAddress] = row;
+    }
+};
+ProcessTable processTable;
+
+// running totals for the deadline report
+// we keep counters and a histogram instead of every lateness value
+// so the report costs the same no matter how many processes run
+struct DeadlineStats {
+    int completed;          // processes with a deadline that terminated
+    int misses;             // how many of them finished after their deadline
+    long long totalLateness; // sum of (termination time - deadline), can be negative
+    int minLateness;        // earliest finish relative to the deadline
+    int maxLateness;        // latest finish relative to the deadline
+    double utilization;     // sum of cpu cycles used / relative deadline
+    int tardinessBuckets[6]; // on time, 1-9, 10-99, 100-999, 1000-9999, 10000+
+
+    DeadlineStats() : completed(0), misses(0), totalLateness(0),
+                      minLateness(INT_MAX), maxLateness(INT_MIN), utilization(0.0) {
+        for (int i = 0; i < 6; i++) {
+            tardinessBuckets[i] = 0;
+        }
+    }
+};
+DeadlineStats deadlineStats;
+
+// the most recent completed cpu bursts, oldest at the front
+deque<int> recentBursts;
+
+// kinds of context switch the cost model tells apart
+enum SwitchKind {
+    SWITCH_REDISPATCH = 0, // the same process runs again with nobody in between
+    SWITCH_WARM = 1,       // the process ran only a few dispatches ago
+    SWITCH_COLD = 2        // the process has not run recently (or ever)
+};
+
+int lastDispatchedProcess = -1; // process ID of the most recent dispatch
+
+// running totals for the scheduling report
+struct SchedulingStats {
+    int dispatches;           // how many times a process was moved to running
+    long long switchTime;     // simulated time spent on context switches
+    int switchCount[3];       // context switches of each SwitchKind
+    long long switchTimeByKind[3]; // simulated switch time of each SwitchKind
+    int timeouts;             // how many time slices ended in a TimeOUT interrupt
+    int terminated;           // how many processes finished
+    long long totalTurnaround; // sum of (termination time - arrival time)
+    long long totalResponse;  // sum of (first run time - arrival time)
+    int quantumAdjustments;   // how many times the adaptive quantum changed
+
+    SchedulingStats() : dispatches(0), switchTime(0), timeouts(0), terminated(0),
+                        totalTurnaround(0), totalResponse(0), quantumAdjustments(0) {
+        for (int i = 0; i < 3; i++) {
+            switchCount[i] = 0;
+            switchTimeByKind[i] = 0;
+        }
+    }
+};
+SchedulingStats schedulingStats;
+
+// backfill bookkeeping for the job at the head of the new job queue
+int blockedHeadID = -1;   // process ID of the head job that could not be loaded
+int headBypassCount = 0;  // how many jobs were loaded ahead of it so far
+
+// running totals for the admission report
+struct AdmissionStats {
+    int admitted;              // jobs loaded into memory
+    int backfilled;            // jobs loaded ahead of a blocked head job
+    int deferrals;             // times a job was left waiting for memory
+    long long totalAdmissionWait; // sum of (load time - arrival time)
+    long long allocatedWords;  // memory currently allocated to processes
+    double usageArea;          // allocated words integrated over simulated time
+    int lastUsageUpdate;       // globalClock value usageArea is accurate up to
+
+    AdmissionStats() : admitted(0), backfilled(0), deferrals(0), totalAdmissionWait(0),
+                       allocatedWords(0), usageArea(0.0), lastUsageUpdate(0) {}
+};
+AdmissionStats admissionStats;
+
+// backing store for the medium-term scheduler
+fstream swapFile;
+long long swapFileEnd = 0;                    // first unused word in the swap file
+vector<pair<long long, int> > swapFileHoles;  // reusable (offset, size) extents in the swap file
+int swapInsWaiting = 0; // swapped out processes whose IO is done but that have no memory yet
+
+// running totals for the swap report
+struct SwapStats {
+    int swapOuts;          // images written to the backing store
+    int swapIns;           // images read back into memory
+    long long wordsOut;    // swap traffic towards the backing store
+    long long wordsIn;     // swap traffic back into memory
+    int swapInStalls;      // checks where a finished process found no memory
+
+    SwapStats() : swapOuts(0), swapIns(0), wordsOut(0), wordsIn(0), swapInStalls(0) {}
+};
+SwapStats swapStats;
+
+// running totals for compaction
+struct CompactionStats {
+    int compactions;       // compaction passes that moved anything
+    int processesMoved;    // process images relocated
+    long long wordsMoved;  // words copied inside mainMemory
+
+    CompactionStats() : compactions(0), processesMoved(0), wordsMoved(0) {}
+};
+CompactionStats compactionStats;
+
+// the process image the idle compactor is moving, if any
+// the image is copied a chunk per idle window; it only becomes usable at
+// its new address once every word has been copied
+struct IdleMove {
+    bool active;
+    int processID;
+    int tableRow;
+    int from;     // old start address
+    int to;       // new start address
+    int size;     // words in the image
+    int copied;   // words copied so far
+
+    IdleMove() : active(false), processID(-1), tableRow(-1), from(0), to(0), size(0), copied(0) {}
+};
+IdleMove idleMove;
+
+// running totals for the idle compactor
+struct IdleCompactionStats {
+    int idleWindows;       // idle windows the compactor ran in
+    int processesMoved;    // moves completed
+    long long wordsMoved;  // words copied, in idle time or when finished early
+    int finishedEarly;     // moves completed outside idle time because memory was needed
+
+    IdleCompactionStats() : idleWindows(0), processesMoved(0), wordsMoved(0), finishedEarly(0) {}
+};
+IdleCompactionStats idleCompactionStats;
+
+// paged memory (--paging)
+// every process image is cut into pages of pageSize words that go into any
+// free frames. PCB addresses are then virtual (the image starts at 0) and
+// each access by the process is translated through its page table. the
+// PCB is the first 10 words of page 0, so a PCB address is still physical
+int pageShift = 0;          // log2 of pageSize
+vector<int> freeFrames;     // free frame pool (a stack that starts with frame 0 on top)
+
+// running totals for the paging report
+struct PagingStats {
+    long long translations;       // virtual addresses translated
+    long long instructions;       // instructions fetched
+    int framesInUse;              // frames held by processes right now
+    int peakFramesInUse;
+    long long pageTableEntries;   // entries in all page tables right now
+    long long peakPageTableEntries;
+    long long unusedWords;        // words past the image end in last pages right now
+    long long peakUnusedWords;
+
+    PagingStats() : translations(0), instructions(0), framesInUse(0), peakFramesInUse(0),
+                    pageTableEntries(0), peakPageTableEntries(0), unusedWords(0), peakUnusedWords(0) {}
+};
+PagingStats pagingStats;
+
+// FORK
+// with paging a child shares the frames of its parent (all but page 0,
+// which holds its own PCB) and a shared page is copied only when one of
+// them STOREs to it. frameRefs counts the page tables using each frame.
+// with demand paging the child gets page file slots of its own instead.
+// a child is numbered above every PID read so far (with --stream a job
+// read later may still reuse its number)
+vector<int> frameRefs;
+int largestProcessID = 0; // largest PID read or given to a child so far
+
+// running totals for the fork report
+struct ForkStats {
+    int forks;               // children created
+    int failures;            // FORKs that found no memory for the child
+    long long pagesShared;   // pages a child got without a copy
+    long long pageCopies;    // shared pages copied on a STORE
+    int copyFailures;        // STOREs to a shared page that found no free frame
+    long long wordsCopied;   // words copied at fork time (page 0, or whole contiguous images)
+    long long pagesToFile;   // demand paging: pages of children written to their own page file slots
+    int dataShared;          // segmented memory: data segments a child got without a copy
+    int dataCopies;          // shared data segments copied on a STORE
+
+    ForkStats() : forks(0), failures(0), pagesShared(0), pageCopies(0), copyFailures(0), wordsCopied(0),
+                  pagesToFile(0), dataShared(0), dataCopies(0) {}
+};
+ForkStats forkStats;
+
+// segmented memory (--segments)
+// a process image gets two blocks from the allocator: a code segment for
+// its opcodes and parameters and a data segment for its PCB and the rest.
+// addresses are virtual as with paging (the image starts at 0) and go
+// through the segment table. jobs whose code is identical share one code
+// segment, found by a hash of its words when the job is loaded; a STORE
+// into a shared code segment first gives the process its own copy
+struct CodeSegment {
+    int refs;                // processes using the segment
+    unsigned long long hash; // hash of the words as loaded
+    bool listed;             // still in codeSegmentsByHash (a STORE changed it otherwise)
+    vector<int> words;       // the words as loaded, to confirm a hash match
+};
+unordered_map<int, CodeSegment> codeSegments;                  // by base address
+unordered_multimap<unsigned long long, int> codeSegmentsByHash; // hash -> base address
+
+// a forked child shares the data segment of its parent until one of them
+// STOREs to it, and its PCB goes in a small block of its own. a block stays
+// allocated while a process reads its data from it or keeps its PCB in it
+// (the process that loaded a data segment does both)
+struct DataSegment {
+    int refs;      // processes reading their data from the block
+    bool holdsPCB; // its first 10 words are the PCB of a live process
+    int limit;     // words in the block
+};
+unordered_map<int, DataSegment> dataSegments; // by base address
+
+// running totals for the segment report
+struct SegmentStats {
+    int loads;                 // jobs loaded
+    int sharedLoads;           // jobs that found their code already loaded
+    int sharedAdmissions;      // jobs whose code would not have fit next to their data
+    long long wordsNotLoaded;  // code words shared instead of loaded
+    long long wordsSaved;      // words shared by more than one process right now
+    long long peakWordsSaved;
+    int liveSegments;          // code segments in memory right now
+    int peakLiveSegments;
+    int codeCopies;            // shared code segments copied on a STORE
+    int copyFailures;          // STOREs to a shared code segment that found no free memory
+
+    SegmentStats() : loads(0), sharedLoads(0), sharedAdmissions(0), wordsNotLoaded(0), wordsSaved(0),
+                     peakWordsSaved(0), liveSegments(0), peakLiveSegments(0), codeCopies(0),
+                     copyFailures(0) {}
+};
+SegmentStats segmentStats;
+
+// who is reading or writing memory: the simulator itself (loading a job,
+// rescanning opcodes) or the running process fetching an instruction or its
+// parameters, or doing a LOAD or STORE. only the process goes through the TLB
+enum MemoryAccess {
+    OS_ACCESS,
+    FETCH_ACCESS,
+    DATA_ACCESS
+};
+
+// translation lookaside buffer (--tlb)
+// a set associative cache of page -> frame translations. the set is picked
+// by the low bits of the page number. without ASIDs the TLB is flushed
+// whenever a different process is dispatched; with them each entry
+// remembers the process it belongs to and survives switches. either way a
+// process's entries go when it terminates or is suspended, since its
+// process ID (and so its ASID) may be used again by a later process
+struct TLBEntry {
+    bool valid;
+    int asid;   // process ID of the owner
+    int page;
+    int frame;
+    long long stamp; // last use (lru) or fill time (fifo)
+
+    TLBEntry() : valid(false), asid(-1), page(-1), frame(-1), stamp(0) {}
+};
+
+struct TLB {
+    vector<TLBEntry> entries; // set after set, tlbWays entries each
+    int sets;
+    long long clock;          // counts lookups, for the stamps
+    mt19937 random;           // victim choice for the random policy
+    int lastProcess;          // process the entries belong to when there are no ASIDs
+    bool touchOnHit;          // lru: a hit refreshes the stamp
+    bool randomVictims;       // random: ignore the stamps when evicting
+    long long hits[3];        // by MemoryAccess
+    long long misses[3];
+    long long flushes;
+    long long missCycles;     // time charged for misses
+
+    TLB() : sets(0), clock(0), random(1), lastProcess(-1), touchOnHit(false), randomVictims(false),
+            flushes(0), missCycles(0) {
+        for (int i = 0; i < 3; i++) {
+            hits[i] = 0;
+            misses[i] = 0;
+        }
+    }
+
+    void init() {
+        if (tlbWays <= 0 || tlbWays > tlbEntries) {
+            tlbWays = tlbEntries;
+        }
+        sets = max(1, tlbEntries / tlbWays);
+        entries.assign(sets * tlbWays, TLBEntry());
+        touchOnHit = (tlbPolicy == "lru");
+        randomVictims = (tlbPolicy == "random");
+    }
+
+    void flush() {
+        for (size_t i = 0; i < entries.size(); i++) {
+            entries[i].valid = false;
+        }
+        flushes++;
+    }
+
+    // called at every dispatch
+    void switchTo(int processID) {
+        if (!tlbASIDs && processID != lastProcess && lastProcess != -1) {
+            flush();
+        }
+        lastProcess = processID;
+    }
+
+    // drops every translation of one process (it left memory)
+    void flushProcess(int processID) {
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].asid == processID) {
+                entries[i].valid = false;
+            }
+        }
+    }
+
+    // drops one translation (the page moved or left memory)
+    void invalidate(int processID, int page) {
+        TLBEntry* set = &entries[(page % sets) * tlbWays];
+        for (int way = 0; way < tlbWays; way++) {
+            if (set[way].valid && set[way].page == page && set[way].asid == processID) {
+                set[way].valid = false;
+            }
+        }
+    }
+
+    // looks a page up; on a miss the page table entry is walked and cached
+    // and the miss penalty goes on the clock
+    int lookup(int row, int page, MemoryAccess access) {
+        int asid = processTable.processID[row];
+        TLBEntry* set = &entries[(page % sets) * tlbWays];
+        clock++;
+        for (int way = 0; way < tlbWays; way++) {
+            if (set[way].valid && set[way].page == page && set[way].asid == asid) {
+                if (touchOnHit) {
+                    set[way].stamp = clock;
+                }
+                hits[access]++;
+                processTable.tlbHits[row]++;
+                return set[way].frame;
+            }
+        }
+
+        // pick a victim: an empty way, else by policy
+        int victim = -1;
+        for (int way = 0; way < tlbWays && victim == -1; way++) {
+            if (!set[way].valid) {
+                victim = way;
+            }
+        }
+        if (victim == -1 && randomVictims) {
+            victim = random() % tlbWays;
+        } else if (victim == -1) {
+            victim = 0; // lru and fifo both evict the oldest stamp
+            for (int way = 1; way < tlbWays; way++) {
+                if (set[way].stamp < set[victim].stamp) {
+                    victim = way;
+                }
+            }
+        }
+        set[victim].valid = true;
+        set[victim].asid = asid;
+        set[victim].page = page;
+        set[victim].frame = processTable.pageTable[row][page];
+        set[victim].stamp = clock;
+
+        misses[access]++;
+        processTable.tlbMisses[row]++;
+        globalClock += tlbMissCycles;
+        missCycles += tlbMissCycles;
+        return set[victim].frame;
+    }
+};
+TLB tlb;
+
+// TLB counts of a terminated process, kept for the final report
+// (its process table row is reused)
+struct TLBProcessCounts {
+    int processID;
+    long long hits;
+    long long misses;
+};
+vector<TLBProcessCounts> tlbProcessCounts; // in termination order
+
+// demand paging (--demand-paging)
+// a process is admitted with only page 0 (its PCB) resident, and that page
+// stays pinned. the other pages come in when the process first touches
+// them; a page of the loaded image is read from the page file, a data page
+// nobody wrote yet is just filled with -1. when no frame is free a victim
+// chosen by the replacement policy is written back (if dirty) and taken
+const int FAULT_RESERVE_FRAMES = 4; // one instruction touches at most 4 pages besides page 0
+const int SUSPEND_FOR_LOAD_CONTROL = -1; // servicePageFaults: take the process out of memory
+vector<int> frameRow;      // process table row owning each frame (-1: free)
+vector<int> framePage;     // page of the owner held by each frame
+vector<char> frameDirty;   // written by a STORE since it was loaded
+vector<char> framePinned;  // a PCB page, never evicted
+vector<char> frameLocked;  // kept for a process's next instruction, not evictable right now
+int pinnedFrames = 0;
+fstream pageFile;
+vector<int> freePageSlots;   // reusable slots in the page file
+int pageSlotsUsed = 0;       // slots ever handed out (the file length in pages)
+long long activeWorkingSet = 0; // working set pages charged to admitted, not suspended processes
+int activeProcesses = 0;        // admitted processes that are not suspended
+queue<int> suspendedProcesses;  // PCB addresses of processes suspended by load control
+
+// running totals for the demand paging report
+struct DemandPagingStats {
+    long long references;      // fetch, parameter and LOAD/STORE accesses by processes
+    long long faults;          // instructions that found a page missing
+    long long pagesIn;         // pages read from the page file
+    long long zeroFills;       // pages that never had contents
+    long long pagesOut;        // dirty or new pages written to the page file
+    long long cleanDrops;      // evicted pages whose page file copy was still good
+    long long imagePages;      // pages of loaded jobs written to the page file at admission
+    long long peakWorkingSet;  // largest total working set of the active processes
+    int suspensions;           // processes taken out of memory by load control
+    int resumes;               // and brought back
+
+    DemandPagingStats() : references(0), faults(0), pagesIn(0), zeroFills(0), pagesOut(0),
+                          cleanDrops(0), imagePages(0), peakWorkingSet(0), suspensions(0), resumes(0) {}
+};
+DemandPagingStats demandStats;
+
+// interface for the demand paging replacement policies
+// only frames holding unpinned pages are ever handed to a policy
+class PageReplacer {
+public:
+    virtual ~PageReplacer() {}
+
+    // the policy's name as given on the command line
+    virtual string name() const = 0;
+
+    // a page was just read (or zero filled) into the frame
+    virtual void loaded(int frame) = 0;
+
+    // an instruction of the running process uses the page in the frame
+    virtual void touched(int frame) = 0;
+
+    // the frame was freed because its process terminated
+    virtual void removed(int frame) = 0;
+
+    // picks a frame to evict and stops tracking it (-1 if every frame is
+    // locked). 'incoming' identifies the page that needs the frame
+    virtual int victim(long long incoming) = 0;
+};
+
+// - HELPER FUNCTION
+// identifies a page across processes (for the ARC history lists)
+long long pageKey(int processID, int page) {
+    return (static_cast<long long>(processID) << 32) | static_cast<unsigned int>(page);
+}
+
+// a doubly linked list of frames kept in arrays (oldest at the head)
+struct FrameList {
+    vector<int> prev;
+    vector<int> next;
+    vector<char> member;
+    int head;
+    int tail;
+    int count;
+
+    void init(int frames) {
+        prev.assign(frames, -1);
+        next.assign(frames, -1);
+        member.assign(frames, 0);
+        head = -1;
+        tail = -1;
+        count = 0;
+    }
+
+    void pushBack(int frame) {
+        prev[frame] = tail;
+        next[frame] = -1;
+        if (tail != -1) {
+            next[tail] = frame;
+        } else {
+            head = frame;
+        }
+        tail = frame;
+        member[frame] = 1;
+        count++;
+    }
+
+    void unlink(int frame) {
+        if (prev[frame] != -1) {
+            next[prev[frame]] = next[frame];
+        } else {
+            head = next[frame];
+        }
+        if (next[frame] != -1) {
+            prev[next[frame]] = prev[frame];
+        } else {
+            tail = prev[frame];
+        }
+        member[frame] = 0;
+        count--;
+    }
+
+    // oldest frame that is not locked (-1 if there is none)
+    int oldestUnlocked() const {
+        for (int frame = head; frame != -1; frame = next[frame]) {
+            if (!frameLocked[frame]) {
+                return frame;
+            }
+        }
+        return -1;
+    }
+};
+
+// first in first out: evicts the page that was loaded longest ago
+class FIFOReplacer : public PageReplacer {
+public:
+    explicit FIFOReplacer(int frames) { order.init(frames); }
+    string name() const { return "fifo"; }
+    void loaded(int frame) { order.pushBack(frame); }
+    void touched(int frame) { (void)frame; }
+    void removed(int frame) {
+        if (order.member[frame]) {
+            order.unlink(frame);
+        }
+    }
+    int victim(long long incoming) {
+        (void)incoming;
+        int frame = order.oldestUnlocked();
+        if (frame != -1) {
+            order.unlink(frame);
+        }
+        return frame;
+    }
+
+private:
+    FrameList order; // load order
+};
+
+// least recently used: every access moves the frame to the back
+class LRUReplacer : public PageReplacer {
+public:
+    explicit LRUReplacer(int frames) { order.init(frames); }
+    string name() const { return "lru"; }
+    void loaded(int frame) { order.pushBack(frame); }
+    void touched(int frame) {
+        if (order.member[frame] && order.tail != frame) {
+            order.unlink(frame);
+            order.pushBack(frame);
+        }
+    }
+    void removed(int frame) {
+        if (order.member[frame]) {
+            order.unlink(frame);
+        }
+    }
+    int victim(long long incoming) {
+        (void)incoming;
+        int frame = order.oldestUnlocked();
+        if (frame != -1) {
+            order.unlink(frame);
+        }
+        return frame;
+    }
+
+private:
+    FrameList order; // least recently used at the head
+};
+
+// clock (second chance): a hand sweeps the frames and evicts the first one
+// whose reference bit is clear, clearing the bits it passes
+class ClockReplacer : public PageReplacer {
+public:
+    explicit ClockReplacer(int frames) : tracked(frames, 0), referenced(frames, 0), hand(0) {}
+    string name() const { return "clock"; }
+    void loaded(int frame) {
+        tracked[frame] = 1;
+        referenced[frame] = 1;
+    }
+    void touched(int frame) { referenced[frame] = 1; }
+    void removed(int frame) { tracked[frame] = 0; }
+    int victim(long long incoming) {
+        (void)incoming;
+        int frames = tracked.size();
+        // two turns are enough: the first clears every reference bit
+        for (int step = 0; step < 2 * frames; step++) {
+            int frame = hand;
+            hand = (hand + 1) % frames;
+            if (!tracked[frame] || frameLocked[frame]) {
+                continue;
+            }
+            if (referenced[frame]) {
+                referenced[frame] = 0;
+                continue;
+            }
+            tracked[frame] = 0;
+            return frame;
+        }
+        return -1;
+    }
+
+private:
+    vector<char> tracked;    // frame holds an evictable page
+    vector<char> referenced; // accessed since the hand last passed
+    int hand;
+};
+
+// adaptive replacement cache (Megiddo and Modha)
+// T1 holds pages seen once recently, T2 pages seen at least twice. B1 and
+// B2 remember the pages evicted from each; a fault on a remembered page
+// moves the target size of T1 (p) towards the list that would have kept it
+class ARCReplacer : public PageReplacer {
+public:
+    explicit ARCReplacer(int frames) : capacity(frames), target(0) {
+        t1.init(frames);
+        t2.init(frames);
+    }
+    string name() const { return "arc"; }
+
+    void loaded(int frame) {
+        long long key = keyOf(frame);
+        if (inB1.count(key)) {
+            target = min(capacity, target + max(1, static_cast<int>(b2.size() / max<size_t>(1, b1.size()))));
+            forget(b1, inB1, key);
+            t2.pushBack(frame);
+        } else if (inB2.count(key)) {
+            target = max(0, target - max(1, static_cast<int>(b1.size() / max<size_t>(1, b2.size()))));
+            forget(b2, inB2, key);
+            t2.pushBack(frame);
+        } else {
+            t1.pushBack(frame);
+        }
+
+        // keep the history within the usual ARC bounds
+        while (t1.count + static_cast<int>(b1.size()) > capacity && !b1.empty()) {
+            inB1.erase(b1.front());
+            b1.pop_front();
+        }
+        while (t1.count + t2.count + static_cast<int>(b1.size() + b2.size()) > 2 * capacity && !b2.empty()) {
+            inB2.erase(b2.front());
+            b2.pop_front();
+        }
+    }
+
+    void touched(int frame) {
+        if (t1.member[frame]) {
+            t1.unlink(frame);
+            t2.pushBack(frame);
+        } else if (t2.member[frame] && t2.tail != frame) {
+            t2.unlink(frame);
+            t2.pushBack(frame);
+        }
+    }
+
+    void removed(int frame) {
+        if (t1.member[frame]) {
+            t1.unlink(frame);
+        } else if (t2.member[frame]) {
+            t2.unlink(frame);
+        }
+    }
+
+    int victim(long long incoming) {
+        // evict from T1 while it is over its target (ties go to T1 if the
+        // incoming page is remembered from T2), else from T2
+        bool fromT1 = t1.count > 0 && (t1.count > target || (inB2.count(incoming) && t1.count == target));
+        int frame = fromT1 ? t1.oldestUnlocked() : t2.oldestUnlocked();
+        if (frame == -1) {
+            fromT1 = !fromT1;
+            frame = fromT1 ? t1.oldestUnlocked() : t2.oldestUnlocked();
+        }
+        if (frame == -1) {
+            return -1;
+        }
+        long long key = keyOf(frame);
+        if (fromT1) {
+            t1.unlink(frame);
+            b1.push_back(key);
+            inB1[key] = --b1.end();
+        } else {
+            t2.unlink(frame);
+            b2.push_back(key);
+            inB2[key] = --b2.end();
+        }
+        return frame;
+    }
+
+private:
+    static long long keyOf(int frame) {
+        return pageKey(processTable.processID[frameRow[frame]], framePage[frame]);
+    }
+
+    static void forget(list<long long>& history, unordered_map<long long, list<long long>::iterator>& index,
+                       long long key) {
+        history.erase(index[key]);
+        index.erase(key);
+    }
+
+    int capacity;   // c: frames available to the policy
+    int target;     // p: target size of T1
+    FrameList t1;
+    FrameList t2;
+    list<long long> b1; // history of pages evicted from T1 (oldest first)
+    list<long long> b2; // history of pages evicted from T2
+    unordered_map<long long, list<long long>::iterator> inB1;
+    unordered_map<long long, list<long long>::iterator> inB2;
+};
+
+// the replacement policy demand paging runs with (NULL: demand paging is off)
+PageReplacer* pageReplacer = NULL;
+
+// - HELPER FUNCTION
+// creates the replacement policy named on the command line
+// returns NULL for an unknown name
+PageReplacer* createReplacer(const string& policyName, int frames) {
+    if (policyName == "fifo") return new FIFOReplacer(frames);
+    if (policyName == "lru") return new LRUReplacer(frames);
+    if (policyName == "clock") return new ClockReplacer(frames);
+    if (policyName == "arc") return new ARCReplacer(frames);
+    return NULL;
+}
+
+// lazy scrubbing
+// freed memory is not overwritten. instead every chunk of SCRUB_CHUNK_WORDS
+// words remembers the epoch it was last freed in and every word the epoch it
+// was last written in. a word written before its chunk was freed is stale and
+// reads as -1 until something writes it again. only chunks that lie entirely
+// inside a freed block are tagged, the words at either end are scrubbed
+// right away (so a tagged chunk never holds a word of a live process)
+const int SCRUB_CHUNK_WORDS = 64;
+unsigned int scrubEpoch = 1;          // stamped on every write, bumped on every lazy free
+vector<unsigned int> wordEpoch;       // epoch of the last write to each word
+vector<unsigned int> chunkFreeEpoch;  // epoch of the last lazy free of each chunk (0: never)
+
+// running totals for the scrub report
+struct ScrubStats {
+    long long wordsFilled;        // words scrubbed by writing -1 into them
+    long long wordsTagged;        // words freed by tagging their chunk instead
+    long long wordsMaterialized;  // stale words given their -1 before a copy or dump
+
+    ScrubStats() : wordsFilled(0), wordsTagged(0), wordsMaterialized(0) {}
+};
+ScrubStats scrubStats;
+
+// fragmentation tracker (--frag-out)
+// follows the holes (maximal runs of words no process occupies) through every
+// allocation, free and move. hole starts are bits in a bitmap with summary
+// levels above it (a bit per non-empty word of the level below), so the hole
+// around an address is found with one word scan per level, however many
+// holes there are. counts and the size histogram are updated as holes come
+// and go, and the holes of each size class are linked into a list (links
+// kept per hole start, like holeEnd), so every update stays O(1) and the
+// exact largest hole is found at sample time among the top class only
+struct FragmentationTracker {
+    vector<vector<unsigned long long> > levels; // levels[0] has a bit per word of memory
+    vector<int> holeEnd;    // one past the last word of the hole starting at each address
+    int memorySize;
+    int freeTotal;
+    int holes;
+    int peakHoles;          // most holes seen since the last sample
+    vector<int> histogram;  // holes by size class (class k holds 2^k to 2^(k+1)-1 words)
+    vector<int> classHead;  // first hole of each size class (-1 if none)
+    vector<int> classNext;  // next and previous hole of the same class, by hole start
+    vector<int> classPrev;
+
+    void init(int size) {
+        memorySize = size;
+        freeTotal = 0;
+        holes = 0;
+        peakHoles = 0;
+        histogram.assign(32 - __builtin_clz(static_cast<unsigned int>(size)), 0);
+        classHead.assign(histogram.size(), -1);
+        classNext.assign(size, -1);
+        classPrev.assign(size, -1);
+        holeEnd.assign(size, 0);
+        int bits = size;
+        do {
+            levels.push_back(vector<unsigned long long>((bits + 63) / 64, 0));
+            bits = (bits + 63) / 64;
+        } while (bits > 1);
+        addHole(0, size);
+    }
+
+    static int sizeClass(int size) {
+        return 31 - __builtin_clz(static_cast<unsigned int>(size));
+    }
+
+    void setBit(int pos) {
+        for (size_t l = 0; l < levels.size(); l++) {
+            unsigned long long& word = levels[l][pos >> 6];
+            bool wasEmpty = (word == 0);
+            word |= 1ULL << (pos & 63);
+            if (!wasEmpty) {
+                return; // the levels above already know about this word
+            }
+            pos >>= 6;
+        }
+    }
+
+    void clearBit(int pos) {
+        for (size_t l = 0; l < levels.size(); l++) {
+            unsigned long long& word = levels[l][pos >> 6];
+            word &= ~(1ULL << (pos & 63));
+            if (word != 0) {
+                return;
+            }
+            pos >>= 6;
+        }
+    }
+
+    // highest set bit at or below pos in a level (-1 if there is none)
+    int previousBit(size_t l, int pos) const {
+        if (pos < 0) {
+            return -1;
+        }
+        int w = pos >> 6;
+        unsigned long long bits = levels[l][w] & ((2ULL << (pos & 63)) - 1);
+        if (bits == 0) {
+            if (l + 1 == levels.size()) {
+                return -1; // the top level is a single word
+            }
+            w = previousBit(l + 1, w - 1);
+            if (w < 0) {
+                return -1;
+            }
+            bits = levels[l][w];
+        }
+        return (w << 6) + 63 - __builtin_clzll(bits);
+    }
+
+    void addHole(int start, int end) {
+        setBit(start);
+        holeEnd[start] = end;
+        freeTotal += end - start;
+        int k = sizeClass(end - start);
+        histogram[k]++;
+        classPrev[start] = -1;
+        classNext[start] = classHead[k];
+        if (classHead[k] != -1) {
+            classPrev[classHead[k]] = start;
+        }
+        classHead[k] = start;
+        holes++;
+        peakHoles = max(peakHoles, holes);
+    }
+
+    void removeHole(int start) {
+        clearBit(start);
+        freeTotal -= holeEnd[start] - start;
+        int k = sizeClass(holeEnd[start] - start);
+        histogram[k]--;
+        if (classPrev[start] != -1) {
+            classNext[classPrev[start]] = classNext[start];
+        } else {
+            classHead[k] = classNext[start];
+        }
+        if (classNext[start] != -1) {
+            classPrev[classNext[start]] = classPrev[start];
+        }
+        holes--;
+    }
+
+    // a process now occupies [start, start + size), which was free
+    void allocated(int start, int size) {
+        int holeStart = previousBit(0, start);
+        int end = holeEnd[holeStart];
+        removeHole(holeStart);
+        if (holeStart < start) {
+            addHole(holeStart, start);
+        }
+        if (start + size < end) {
+            addHole(start + size, end);
+        }
+    }
+
+    // [start, start + size) is free again; merge it with the holes either side
+    void freed(int start, int size) {
+        int end = start + size;
+        if (end < memorySize && (levels[0][end >> 6] >> (end & 63) & 1)) {
+            int rightEnd = holeEnd[end];
+            removeHole(end);
+            end = rightEnd;
+        }
+        int leftStart = previousBit(0, start - 1);
+        if (leftStart != -1 && holeEnd[leftStart] == start) {
+            removeHole(leftStart);
+            start = leftStart;
+        }
+        addHole(start, end);
+    }
+
+    // exact size of the largest hole: only holes in the highest non-empty
+    // size class can be it, so only those are looked at
+    int largestHole() const {
+        int top = static_cast<int>(histogram.size()) - 1;
+        while (top >= 0 && histogram[top] == 0) {
+            top--;
+        }
+        int largest = 0;
+        if (top < 0) {
+            return 0;
+        }
+        for (int start = classHead[top]; start != -1; start = classNext[start]) {
+            largest = max(largest, holeEnd[start] - start);
+        }
+        return largest;
+    }
+};
+FragmentationTracker fragmentationTracker;
+ofstream fragmentationFile;
+int nextFragmentationSample = 0;
+
+// - HELPER FUNCTION
+// writes the fragmentation samples that are due up to the current time
+// (memory only changes at events, so a sample shows the state before the
+// event that triggered it). the header row is written by main
+void sampleFragmentation(int upToTime) {
+    while (nextFragmentationSample <= upToTime) {
+        const FragmentationTracker& tracker = fragmentationTracker;
+        int largest = tracker.largestHole();
+        fragmentationFile << nextFragmentationSample << ',' << tracker.freeTotal << ',' << largest << ','
+                          << tracker.holes << ',' << tracker.peakHoles << ','
+                          << (tracker.freeTotal > 0 ? 1.0 - static_cast<double>(largest) / tracker.freeTotal : 0.0);
+        for (size_t k = 0; k < tracker.histogram.size(); k++) {
+            fragmentationFile << ',' << tracker.histogram[k];
+        }
+        fragmentationFile << '\n';
+        fragmentationTracker.peakHoles = tracker.holes;
+        nextFragmentationSample += fragmentationEvery;
+    }
+}
+
+// state of the arrival time generator
+mt19937 arrivalRandom;
+double lastGeneratedArrival = 0.0;
+
+// running totals for the arrival report
+struct ArrivalStats {
+    int arrivals;              // jobs that entered the system
+    int lastArrival;           // arrival time of the latest job
+    long long totalCPUCycles;  // cpu cycles used by terminated jobs (their service demand)
+
+    ArrivalStats() : arrivals(0), lastArrival(0), totalCPUCycles(0) {}
+};
+ArrivalStats arrivalStats;
+
+// - HELPER FUNCTION
+// converts a process state enum to a string for output
+// this makes the output more readable for humans
+string stateToString(ProcessState state) {
+    switch (state) {
+        case STATE_NEW: return "NEW";
+        case STATE_READY: return "READY";
+        case STATE_RUNNING: return "RUNNING";
+        case STATE_TERMINATED: return "TERMINATED";
+        case STATE_IOWAITING: return "IOWAITING";
+        default: return "UNKNOWN";
+    }
+}
+
+// - HELPER FUNCTION
+// gets the number of parameters for a specific instruction type
+// this is used when reading instructions and calculating parameter offsets
+int getParameterCount(InstructionType type) {
+    switch (type) {
+        case COMPUTE: return 2; // compute needs iterations and cycles
+        case PRINT: return 1;   // print only needs cycles
+        case STORE: return 2;   // store needs value and address
+        case LOAD: return 1;    // load only needs address
+        case FORK: return 0;    // fork has no parameters
+        default: return 0;      // unknown instruction type has no parameters
+    }
+}
+
+// - HELPER FUNCTION
+// gets the time a process arrived in the system
+int getArrivalTime(int row) {
+    return processTable.arrivalTime[row];
+}
+
+// - HELPER FUNCTION
+// gets the absolute deadline of a process
+// processes without a deadline sort after every process that has one
+int getDeadline(int row) {
+    return processTable.deadline[row].absolute;
+}
+
+// - HELPER FUNCTION
+// records how a process with a deadline finished
+// this is called once per process at termination time
+void recordDeadlineResult(int row, int cpuCyclesUsed) {
+    const ProcessDeadline& deadline = processTable.deadline[row];
+    if (deadline.relative <= 0) {
+        return; // process has no deadline, nothing to record
+    }
+
+    // lateness is negative when the process finished early
+    int lateness = globalClock - deadline.absolute;
+    deadlineStats.completed++;
+    deadlineStats.totalLateness += lateness;
+    deadlineStats.minLateness = min(deadlineStats.minLateness, lateness);
+    deadlineStats.maxLateness = max(deadlineStats.maxLateness, lateness);
+    deadlineStats.utilization += static_cast<double>(cpuCyclesUsed) / deadline.relative;
+
+    // put the tardiness into a power of ten bucket
+    int bucket = 0;
+    if (lateness > 0) {
+        deadlineStats.misses++;
+        bucket = 1;
+        for (int limit = 10; bucket < 5 && lateness >= limit; limit *= 10) {
+            bucket++;
+        }
+    }
+    deadlineStats.tardinessBuckets[bucket]++;
+}
+
+// - HELPER FUNCTION
+// prints the deadline report at the end of the simulation
+void printDeadlineReport() {
+    cout << "Deadline report (" << (schedulingPolicy == "edf" ? "EDF" : "RR") << "):" << endl;
+    cout << "Processes with deadlines: " << deadlineStats.completed << endl;
+    if (deadlineStats.completed == 0) {
+        return;
+    }
+    cout << "Deadline misses: " << deadlineStats.misses << " ("
+         << (100.0 * deadlineStats.misses / deadlineStats.completed) << "%)" << endl;
+    cout << "Lateness: min " << deadlineStats.minLateness
+         << ", mean " << (static_cast<double>(deadlineStats.totalLateness) / deadlineStats.completed)
+         << ", max " << deadlineStats.maxLateness << endl;
+    cout << "Tardiness distribution: on time " << deadlineStats.tardinessBuckets[0]
+         << ", 1-9 " << deadlineStats.tardinessBuckets[1]
+         << ", 10-99 " << deadlineStats.tardinessBuckets[2]
+         << ", 100-999 " << deadlineStats.tardinessBuckets[3]
+         << ", 1000-9999 " << deadlineStats.tardinessBuckets[4]
+         << ", 10000+ " << deadlineStats.tardinessBuckets[5] << endl;
+    cout << "Total utilization: " << deadlineStats.utilization << endl;
+}
+
+// - HELPER FUNCTION
+// brings the memory utilization integral up to the current time
+// called right before the amount of allocated memory changes
+void updateMemoryUsage(long long allocatedChange) {
+    admissionStats.usageArea += static_cast<double>(admissionStats.allocatedWords) *
+                                (globalClock - admissionStats.lastUsageUpdate);
+    admissionStats.lastUsageUpdate = globalClock;
+    admissionStats.allocatedWords += allocatedChange;
+}
+
+// placement policies for the linked list allocator
+enum PlacementPolicy {
+    FIRST_FIT = 1, // lowest addressed free block that is big enough
+    NEXT_FIT = 2,  // like first fit, but the search resumes where the last one stopped
+    BEST_FIT = 3,  // smallest free block that is big enough
+    WORST_FIT = 4  // largest free block
+};
+
+// interface every simulated memory allocator implements
+// addresses and sizes are in words of mainMemory; the simulator only
+// talks to the allocator through these calls, so backends can be swapped
+class MemoryAllocator {
+public:
+    virtual ~MemoryAllocator() {}
+
+    // short name used in reports
+    virtual string name() const = 0;
+
+    // finds room for 'size' words for a process, returns the start address or -1
+    virtual int allocate(int processID, int size) = 0;
+
+    // gives back the block that starts at 'address'
+    virtual void release(int address) = 0;
+
+    // merges neighbouring free blocks (nothing to do for allocators that merge on release)
+    virtual void coalesce() {}
+
+    // size of the largest block allocate() could hand out after coalesce()
+    virtual int largestFreeBlock() const = 0;
+
+    // total number of free words
+    virtual int freeWords() const = 0;
+
+    // number of separate free regions (holes)
+    virtual int freeBlockCount() const = 0;
+
+    // true if release() already merges neighbours, so a failed allocation
+    // cannot be rescued by coalesce() and the retry can be skipped
+    virtual bool coalescesOnRelease() const { return false; }
+
+    // where a first fit allocator would place 'size' words right now
+    // (-1 if it would not fit)
+    virtual int firstFitAddress(int size) const { (void)size; return -1; }
+
+    // prints counters specific to this allocator (nothing by default)
+    virtual void printStatistics() const {}
+
+    // true if allocateAt() works, which compaction needs to move blocks
+    virtual bool canRelocate() const { return false; }
+
+    // words a block of 'size' words really takes (more if the allocator rounds up)
+    virtual int roundedSize(int size) const { return size; }
+
+    // true if allocate() could place 'size' words in [start, end) once that
+    // whole range is free
+    virtual bool fitsInRange(int start, int end, int size) const { return end - start >= size; }
+
+    // reserves exactly [address, address + size) for a process
+    // the range must be free; returns false if it is not
+    virtual bool allocateAt(int processID, int address, int size) {
+        (void)processID; (void)address; (void)size;
+        return false;
+    }
+
+    // takes the layout compaction leaves in one pass: 'used' holds every
+    // allocated block, packed from address 0 in address order, and the rest
+    // of memory is one free block. returns false if the allocator has no
+    // such shortcut (compaction then moves the blocks one by one)
+    virtual bool rebuildCompacted(const vector<MemoryBlock>& used) { (void)used; return false; }
+};
+
+// the original allocator: a linked list of free and allocated blocks in
+// address order; free blocks are only merged when coalesce() is called
+class ListAllocator : public MemoryAllocator {
+public:
+    ListAllocator(int memorySize, PlacementPolicy placement) : policy(placement), freeTotal(memorySize) {
+        // start with one big free block
+        blocks.push_back(MemoryBlock(-1, 0, memorySize));
+        rover = blocks.begin();
+    }
+
+    string name() const {
+        switch (policy) {
+            case FIRST_FIT: return "first-fit";
+            case NEXT_FIT: return "next-fit";
+            case BEST_FIT: return "best-fit";
+            case WORST_FIT: return "worst-fit";
+            default: return "list";
+        }
+    }
+
+    int allocate(int processID, int size) {
+        list<MemoryBlock>::iterator current = findFreeBlock(size);
+        if (current == blocks.end()) {
+            return -1; // no suitable block was found
+        }
+
+        // found a suitable block, remember its starting address
+        int allocatedAddress = current->startAddress;
+        freeTotal -= size;
+
+        // if the block is exactly the right size, just mark it as allocated
+        if (current->size == size) {
+            current->processID = processID;
+            allocatedBlocks[allocatedAddress] = current;
+            rover = current;
+            ++rover;
+            if (rover == blocks.end()) {
+                rover = blocks.begin();
+            }
+            return allocatedAddress;
+        }
+
+        // if the block is larger than needed, split it into two parts
+        // first part is allocated to the process, second part remains free
+        list<MemoryBlock>::iterator newBlock = blocks.insert(current,
+                                                MemoryBlock(processID, current->startAddress, size));
+        allocatedBlocks[allocatedAddress] = newBlock;
+
+        // adjust the remaining free portion
+        current->startAddress += size;
+        current->size -= size;
+        rover = current;
+        return allocatedAddress;
+    }
+
+    void release(int address) {
+        unordered_map<int, list<MemoryBlock>::iterator>::iterator it = allocatedBlocks.find(address);
+        if (it == allocatedBlocks.end()) {
+            return;
+        }
+        // mark the block as free
+        it->second->processID = -1;
+        freeTotal += it->second->size;
+        allocatedBlocks.erase(it);
+    }
+
+    void coalesce() {
+        // start at the beginning of the memory blocks list
+        list<MemoryBlock>::iterator current = blocks.begin();
+
+        // scan through the list looking for adjacent free blocks
+        while (current != blocks.end()) {
+            // get the next block
+            list<MemoryBlock>::iterator next = current;
+            ++next;
+
+            // check if we've reached the end of the list
+            if (next == blocks.end()) {
+                break;
+            }
+
+            // if both current and next blocks are free, merge them
+            if (current->processID == -1 && next->processID == -1) {
+                // add next block's size to current block
+                current->size += next->size;
+                // the next-fit search must not resume inside a removed block
+                if (rover == next) {
+                    rover = current;
+                }
+                // remove the next block since it's now part of the current block
+                blocks.erase(next);
+                // don't move to the next block yet, check if we can merge more
+            }
+            else {
+                // blocks can't be merged, move to the next block
+                ++current;
+            }
+        }
+    }
+
+    // neighbouring free blocks are counted together, so this is the
+    // largest block that would exist after coalesce()
+    int largestFreeBlock() const {
+        int largest = 0;
+        int run = 0;
+        for (list<MemoryBlock>::const_iterator it = blocks.begin(); it != blocks.end(); ++it) {
+            if (it->processID == -1) {
+                run += it->size;
+                largest = max(largest, run);
+            } else {
+                run = 0;
+            }
+        }
+        return largest;
+    }
+
+    int freeWords() const {
+        return freeTotal;
+    }
+
+    int freeBlockCount() const {
+        int holes = 0;
+        bool inHole = false;
+        for (list<MemoryBlock>::const_iterator it = blocks.begin(); it != blocks.end(); ++it) {
+            if (it->processID == -1 && !inHole) {
+                holes++;
+            }
+            inHole = (it->processID == -1);
+        }
+        return holes;
+    }
+
+    bool canRelocate() const {
+        return true;
+    }
+
+    bool allocateAt(int processID, int address, int size) {
+        // the range may span free blocks that were not merged yet
+        list<MemoryBlock>::iterator current = freeBlockContaining(address);
+        if (current == blocks.end() || current->startAddress + current->size < address + size) {
+            coalesce();
+            current = freeBlockContaining(address);
+        }
+        if (current == blocks.end() || current->startAddress + current->size < address + size) {
+            return false;
+        }
+
+        // split off the free words in front of the range
+        if (current->startAddress < address) {
+            blocks.insert(current, MemoryBlock(-1, current->startAddress, address - current->startAddress));
+            current->size -= address - current->startAddress;
+            current->startAddress = address;
+        }
+
+        // carve the new block from the front of what is left
+        list<MemoryBlock>::iterator newBlock = blocks.insert(current, MemoryBlock(processID, address, size));
+        allocatedBlocks[address] = newBlock;
+        current->startAddress += size;
+        current->size -= size;
+        if (current->size == 0) {
+            bool roverHere = (rover == current);
+            list<MemoryBlock>::iterator after = blocks.erase(current);
+            if (roverHere) {
+                rover = (after == blocks.end()) ? blocks.begin() : after;
+            }
+        }
+        freeTotal -= size;
+        return true;
+    }
+
+    // one allocateAt() per block would search the list each time; the
+    // compacted list is just the blocks in order and one free block after them
+    bool rebuildCompacted(const vector<MemoryBlock>& used) {
+        int memorySize = freeTotal;
+        for (list<MemoryBlock>::const_iterator it = blocks.begin(); it != blocks.end(); ++it) {
+            if (it->processID != -1) {
+                memorySize += it->size;
+            }
+        }
+        blocks.clear();
+        allocatedBlocks.clear();
+        int end = 0;
+        for (size_t i = 0; i < used.size(); i++) {
+            allocatedBlocks[used[i].startAddress] = blocks.insert(blocks.end(), used[i]);
+            end += used[i].size;
+        }
+        if (end < memorySize) {
+            blocks.push_back(MemoryBlock(-1, end, memorySize - end));
+            rover = --blocks.end();
+        } else {
+            rover = blocks.begin();
+        }
+        freeTotal = memorySize - end;
+        return true;
+    }
+
+    // the lowest addressed free block that is big enough, as the first fit
+    // policy of this list would pick it (free blocks not merged yet count apart)
+    int firstFitAddress(int size) const {
+        for (list<MemoryBlock>::const_iterator current = blocks.begin(); current != blocks.end(); ++current) {
+            if (current->processID == -1 && current->size >= size) {
+                return current->startAddress;
+            }
+        }
+        return -1;
+    }
+
+private:
+    // the free block that holds 'address', or blocks.end()
+    list<MemoryBlock>::iterator freeBlockContaining(int address) {
+        for (list<MemoryBlock>::iterator current = blocks.begin(); current != blocks.end(); ++current) {
+            if (current->processID == -1 && current->startAddress <= address &&
+                address < current->startAddress + current->size) {
+                return current;
+            }
+        }
+        return blocks.end();
+    }
+
+    // picks the free block the placement policy wants, or blocks.end()
+    list<MemoryBlock>::iterator findFreeBlock(int size) {
+        list<MemoryBlock>::iterator chosen = blocks.end();
+
+        if (policy == NEXT_FIT) {
+            // search from the rover to the end, then wrap around to it
+            list<MemoryBlock>::iterator current = rover;
+            do {
+                if (current->processID == -1 && current->size >= size) {
+                    return current;
+                }
+                ++current;
+                if (current == blocks.end()) {
+                    current = blocks.begin();
+                }
+            } while (current != rover);
+            return blocks.end();
+        }
+
+        // search through all memory blocks
+        for (list<MemoryBlock>::iterator current = blocks.begin(); current != blocks.end(); ++current) {
+            // skip blocks that are in use or too small
+            if (current->processID != -1 || current->size < size) {
+                continue;
+            }
+            if (policy == FIRST_FIT) {
+                return current;
+            }
+            // best and worst fit keep the lowest addressed block on ties
+            if (chosen == blocks.end() ||
+                (policy == BEST_FIT && current->size < chosen->size) ||
+                (policy == WORST_FIT && current->size > chosen->size)) {
+                chosen = current;
+            }
+        }
+        return chosen;
+    }
+
+    list<MemoryBlock> blocks;    // all memory blocks (free and allocated) in address order
+    unordered_map<int, list<MemoryBlock>::iterator> allocatedBlocks; // start address -> block
+    PlacementPolicy policy;      // how a free block is chosen
+    list<MemoryBlock>::iterator rover; // next fit: where the next search starts
+    int freeTotal;               // free words in all blocks
+};
+
+// allocator with balanced search tree indexes over the free blocks
+// one index is ordered by address (to find neighbours), the other by
+// size (for best fit); release() merges with both neighbours right away,
+// so allocate, release and the largest-block query are all O(log n)
+class IndexedAllocator : public MemoryAllocator {
+public:
+    IndexedAllocator(int memorySize) : freeTotal(memorySize) {
+        // start with one big free block
+        addFreeBlock(0, memorySize);
+    }
+
+    string name() const {
+        return "indexed";
+    }
+
+    int allocate(int processID, int size) {
+        // smallest free block that is big enough (lowest address on ties)
+        set<pair<int, int> >::iterator fit = freeBySize.lower_bound(make_pair(size, -1));
+        if (fit == freeBySize.end()) {
+            return -1; // no suitable block was found
+        }
+        int blockSize = fit->first;
+        int allocatedAddress = fit->second;
+        removeFreeBlock(allocatedAddress, blockSize);
+
+        // the remainder of the block stays free
+        if (blockSize > size) {
+            addFreeBlock(allocatedAddress + size, blockSize - size);
+        }
+        allocatedSizes[allocatedAddress] = size;
+        freeTotal -= size;
+        (void)processID; // blocks are looked up by address, not owner
+        return allocatedAddress;
+    }
+
+    void release(int address) {
+        unordered_map<int, int>::iterator it = allocatedSizes.find(address);
+        if (it == allocatedSizes.end()) {
+            return;
+        }
+        int start = address;
+        int size = it->second;
+        freeTotal += size;
+        allocatedSizes.erase(it);
+
+        // merge with the free block right after this one
+        map<int, int>::iterator next = freeByAddress.lower_bound(start);
+        if (next != freeByAddress.end() && next->first == start + size) {
+            size += next->second;
+            removeFreeBlock(next->first, next->second);
+        }
+
+        // merge with the free block right before this one
+        map<int, int>::iterator prev = freeByAddress.lower_bound(start);
+        if (prev != freeByAddress.begin()) {
+            --prev;
+            if (prev->first + prev->second == start) {
+                start = prev->first;
+                size += prev->second;
+                removeFreeBlock(prev->first, prev->second);
+            }
+        }
+
+        addFreeBlock(start, size);
+    }
+
+    int largestFreeBlock() const {
+        return freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+    }
+
+    int freeWords() const {
+        return freeTotal;
+    }
+
+    int freeBlockCount() const {
+        return freeByAddress.size();
+    }
+
+    // free blocks are merged on release, so the address index walks the holes in order
+    int firstFitAddress(int size) const {
+        for (map<int, int>::const_iterator block = freeByAddress.begin(); block != freeByAddress.end(); ++block) {
+            if (block->second >= size) {
+                return block->first;
+            }
+        }
+        return -1;
+    }
+
+    bool coalescesOnRelease() const {
+        return true;
+    }
+
+    bool canRelocate() const {
+        return true;
+    }
+
+    bool allocateAt(int processID, int address, int size) {
+        (void)processID; // blocks are looked up by address, not owner
+        // the free block starting at or before the address must cover the range
+        map<int, int>::iterator block = freeByAddress.upper_bound(address);
+        if (block == freeByAddress.begin()) {
+            return false;
+        }
+        --block;
+        int blockStart = block->first;
+        int blockSize = block->second;
+        if (blockStart + blockSize < address + size) {
+            return false;
+        }
+        removeFreeBlock(blockStart, blockSize);
+
+        // what is left on either side stays free
+        if (blockStart < address) {
+            addFreeBlock(blockStart, address - blockStart);
+        }
+        if (blockStart + blockSize > address + size) {
+            addFreeBlock(address + size, blockStart + blockSize - address - size);
+        }
+        allocatedSizes[address] = size;
+        freeTotal -= size;
+        return true;
+    }
+
+private:
+    void addFreeBlock(int start, int size) {
+        freeByAddress[start] = size;
+        freeBySize.insert(make_pair(size, start));
+    }
+
+    void removeFreeBlock(int start, int size) {
+        freeByAddress.erase(start);
+        freeBySize.erase(make_pair(size, start));
+    }
+
+    map<int, int> freeByAddress;          // free blocks: start address -> size
+    set<pair<int, int> > freeBySize;      // free blocks: (size, start address)
+    unordered_map<int, int> allocatedSizes; // allocated blocks: start address -> size
+    int freeTotal;                        // free words in all blocks
+};
+
+// size classes of the TLSF allocator
+// the first level splits sizes by power of two, the second level splits
+// each power of two range into TLSF_SL_COUNT equal parts
+const int TLSF_SL_LOG2 = 4;
+const int TLSF_SL_COUNT = 1 << TLSF_SL_LOG2;
+const int TLSF_FL_COUNT = 32;
+
+// two-level segregated fit (TLSF) allocator
+// every free block sits in the list of its size class and two bitmaps
+// record which classes are non-empty, so a fitting class is found with
+// two bit scans; boundary tags (block size at a block's first word, block
+// start at its last word) are kept in arrays beside mainMemory so both
+// neighbours of a released block are found directly. release is O(1)
+// and merges blocks right away. allocate is O(1) while a class above the
+// request's own has a block; when only the request's own class might fit
+// (memory nearly full) it walks that one class list, so it is linear in
+// the length of that list
+class TLSFAllocator : public MemoryAllocator {
+public:
+    TLSFAllocator(int memorySize) :
+        memorySize(memorySize), blockSizeAt(memorySize, 0), blockStartAt(memorySize, 0),
+        isFree(memorySize, 0), nextFree(memorySize, -1), prevFree(memorySize, -1),
+        flBitmap(0), freeTotal(memorySize), freeCount(0) {
+        for (int fl = 0; fl < TLSF_FL_COUNT; fl++) {
+            slBitmap[fl] = 0;
+            for (int sl = 0; sl < TLSF_SL_COUNT; sl++) {
+                freeLists[fl][sl] = -1;
+            }
+        }
+        // start with one big free block
+        if (memorySize > 0) {
+            insertFreeBlock(0, memorySize);
+        }
+    }
+
+    string name() const {
+        return "tlsf";
+    }
+
+    int allocate(int processID, int size) {
+        (void)processID; // blocks are looked up by address, not owner
+        if (size <= 0 || size > memorySize) {
+            return -1;
+        }
+
+        // round the size up to the next class so any block found is big enough
+        int fl, sl;
+        mappingSearch(size, fl, sl);
+        int block = findSuitableBlock(fl, sl);
+
+        // the rounding can skip a block in the request's own class that
+        // would still fit; look there before giving up
+        if (block == -1) {
+            mappingInsert(size, fl, sl);
+            for (int candidate = freeLists[fl][sl]; candidate != -1; candidate = nextFree[candidate]) {
+                if (blockSizeAt[candidate] >= size) {
+                    block = candidate;
+                    break;
+                }
+            }
+            if (block == -1) {
+                return -1; // no suitable block was found
+            }
+        }
+
+        // take the block and give the remainder back
+        removeFreeBlock(block);
+        int blockSize = blockSizeAt[block];
+        if (blockSize > size) {
+            insertFreeBlock(block + size, blockSize - size);
+        }
+        setTags(block, size);
+        freeTotal -= size;
+        return block;
+    }
+
+    void release(int address) {
+        if (address < 0 || address >= memorySize || isFree[address] || blockSizeAt[address] == 0) {
+            return;
+        }
+        int start = address;
+        int size = blockSizeAt[address];
+        freeTotal += size;
+
+        // merge with the block right after this one if it is free
+        int next = start + size;
+        if (next < memorySize && isFree[next]) {
+            removeFreeBlock(next);
+            size += blockSizeAt[next];
+            blockSizeAt[next] = 0;
+        }
+
+        // merge with the block right before this one if it is free
+        if (start > 0) {
+            int prev = blockStartAt[start - 1];
+            if (isFree[prev]) {
+                removeFreeBlock(prev);
+                blockSizeAt[start] = 0;
+                size += blockSizeAt[prev];
+                start = prev;
+            }
+        }
+
+        insertFreeBlock(start, size);
+    }
+
+    int largestFreeBlock() const {
+        if (flBitmap == 0) {
+            return 0;
+        }
+        // the largest block is in the highest non-empty class
+        int fl = 31 - __builtin_clz(flBitmap);
+        int sl = 31 - __builtin_clz(slBitmap[fl]);
+        int largest = 0;
+        for (int block = freeLists[fl][sl]; block != -1; block = nextFree[block]) {
+            largest = max(largest, blockSizeAt[block]);
+        }
+        return largest;
+    }
+
+    int freeWords() const {
+        return freeTotal;
+    }
+
+    int freeBlockCount() const {
+        return freeCount;
+    }
+
+    bool coalescesOnRelease() const {
+        return true;
+    }
+
+    bool canRelocate() const {
+        return true;
+    }
+
+    bool allocateAt(int processID, int address, int size) {
+        (void)processID; // blocks are looked up by address, not owner
+        if (address < 0 || size <= 0 || address + size > memorySize) {
+            return false;
+        }
+        // compaction asks for the start of a free block; anything else
+        // is found by walking the boundary tags
+        int block = address;
+        if (!isFree[address] || blockSizeAt[address] == 0) {
+            block = 0;
+            while (block < memorySize && block + blockSizeAt[block] <= address) {
+                block += blockSizeAt[block];
+            }
+        }
+        if (block >= memorySize || !isFree[block] || block + blockSizeAt[block] < address + size) {
+            return false;
+        }
+        int blockSize = blockSizeAt[block];
+        removeFreeBlock(block);
+
+        // what is left on either side stays free
+        if (block < address) {
+            insertFreeBlock(block, address - block);
+        }
+        if (block + blockSize > address + size) {
+            insertFreeBlock(address + size, block + blockSize - address - size);
+        }
+        setTags(address, size);
+        freeTotal -= size;
+        return true;
+    }
+
+    // walks the physical blocks through their boundary tags
+    int firstFitAddress(int size) const {
+        for (int block = 0; block < memorySize; block += blockSizeAt[block]) {
+            if (isFree[block] && blockSizeAt[block] >= size) {
+                return block;
+            }
+        }
+        return -1;
+    }
+
+private:
+    // size class a block of 'size' words is filed under
+    void mappingInsert(long long size, int& fl, int& sl) const {
+        int topBit = 63 - __builtin_clzll(size);
+        if (topBit < TLSF_SL_LOG2) {
+            fl = 0;
+            sl = static_cast<int>(size);
+        } else {
+            fl = topBit - TLSF_SL_LOG2 + 1;
+            sl = static_cast<int>(size >> (topBit - TLSF_SL_LOG2)) - TLSF_SL_COUNT;
+        }
+    }
+
+    // first size class whose blocks are all at least 'size' words
+    void mappingSearch(long long size, int& fl, int& sl) const {
+        int topBit = 63 - __builtin_clzll(size);
+        if (topBit >= TLSF_SL_LOG2) {
+            size += (1LL << (topBit - TLSF_SL_LOG2)) - 1;
+        }
+        mappingInsert(size, fl, sl);
+    }
+
+    // head of the first non-empty list at or above class (fl, sl), or -1
+    int findSuitableBlock(int fl, int sl) const {
+        if (fl >= TLSF_FL_COUNT) {
+            return -1;
+        }
+        unsigned int slMap = slBitmap[fl] & (~0u << sl);
+        if (slMap == 0) {
+            unsigned int flMap = (fl + 1 < TLSF_FL_COUNT) ? (flBitmap & (~0u << (fl + 1))) : 0;
+            if (flMap == 0) {
+                return -1;
+            }
+            fl = __builtin_ctz(flMap);
+            slMap = slBitmap[fl];
+        }
+        sl = __builtin_ctz(slMap);
+        return freeLists[fl][sl];
+    }
+
+    // writes the boundary tags of a block
+    void setTags(int start, int size) {
+        blockSizeAt[start] = size;
+        blockStartAt[start + size - 1] = start;
+    }
+
+    void insertFreeBlock(int start, int size) {
+        setTags(start, size);
+        isFree[start] = 1;
+        int fl, sl;
+        mappingInsert(size, fl, sl);
+        prevFree[start] = -1;
+        nextFree[start] = freeLists[fl][sl];
+        if (freeLists[fl][sl] != -1) {
+            prevFree[freeLists[fl][sl]] = start;
+        }
+        freeLists[fl][sl] = start;
+        flBitmap |= 1u << fl;
+        slBitmap[fl] |= 1u << sl;
+        freeCount++;
+    }
+
+    void removeFreeBlock(int start) {
+        int fl, sl;
+        mappingInsert(blockSizeAt[start], fl, sl);
+        if (prevFree[start] != -1) {
+            nextFree[prevFree[start]] = nextFree[start];
+        } else {
+            freeLists[fl][sl] = nextFree[start];
+        }
+        if (nextFree[start] != -1) {
+            prevFree[nextFree[start]] = prevFree[start];
+        }
+        if (freeLists[fl][sl] == -1) {
+            slBitmap[fl] &= ~(1u << sl);
+            if (slBitmap[fl] == 0) {
+                flBitmap &= ~(1u << fl);
+            }
+        }
+        isFree[start] = 0;
+        freeCount--;
+    }
+
+    int memorySize;
+    vector<int> blockSizeAt;    // boundary tag at a block's first word: its size
+    vector<int> blockStartAt;   // boundary tag at a block's last word: its start
+    vector<unsigned char> isFree; // at a block's first word: 1 if the block is free
+    vector<int> nextFree;       // free list links, kept at a free block's first word
+    vector<int> prevFree;
+    int freeLists[TLSF_FL_COUNT][TLSF_SL_COUNT]; // head of each size class list (-1 if empty)
+    unsigned int flBitmap;      // bit fl set if any second level list of fl is non-empty
+    unsigned int slBitmap[TLSF_FL_COUNT]; // bit sl set if list (fl, sl) is non-empty
+    int freeTotal;              // free words in all blocks
+    int freeCount;              // number of free blocks
+};
+
+// binary buddy allocator
+// every block is a power of two words and starts at a multiple of its size;
+// a request is rounded up to the next power of two and a larger block is
+// split in halves until it fits, and on release a block is merged with its
+// buddy (address ^ size) for as long as the buddy is free and whole. both
+// walk at most log2(memory) orders. memory that is not a power of two is
+// carved into the largest aligned power of two blocks that fit
+class BuddyAllocator : public MemoryAllocator {
+public:
+    BuddyAllocator(int memorySize) :
+        memorySize(memorySize), maxOrder(0), freeOrder(memorySize, -1), allocatedOrder(memorySize, -1),
+        requestedSize(memorySize, 0), nextFree(memorySize, -1), prevFree(memorySize, -1),
+        freeTotal(memorySize), freeCount(0), splits(0), merges(0), internalWords(0),
+        peakInternalWords(0), requestedTotal(0), roundedTotal(0) {
+        while (maxOrder < 30 && (1 << (maxOrder + 1)) <= memorySize) {
+            maxOrder++;
+        }
+        freeLists.assign(maxOrder + 1, -1);
+
+        // carve memory largest block first so each block is aligned to its size
+        int address = 0;
+        for (int order = maxOrder; order >= 0 && memorySize > 0; order--) {
+            if (memorySize - address >= (1 << order)) {
+                insertFreeBlock(address, order);
+                address += 1 << order;
+            }
+        }
+    }
+
+    string name() const {
+        return "buddy";
+    }
+
+    int allocate(int processID, int size) {
+        (void)processID; // blocks are looked up by address, not owner
+        if (size <= 0 || size > memorySize) {
+            return -1;
+        }
+
+        // smallest order that holds the request
+        int order = 0;
+        while ((1 << order) < size) {
+            order++;
+        }
+        if (order > maxOrder) {
+            return -1;
+        }
+
+        // smallest non-empty order at or above it
+        int foundOrder = order;
+        while (foundOrder <= maxOrder && freeLists[foundOrder] == -1) {
+            foundOrder++;
+        }
+        if (foundOrder > maxOrder) {
+            return -1; // no suitable block was found
+        }
+
+        // split the block, keeping the lower half and freeing the upper one
+        int block = freeLists[foundOrder];
+        removeFreeBlock(block);
+        while (foundOrder > order) {
+            foundOrder--;
+            insertFreeBlock(block + (1 << foundOrder), foundOrder);
+            splits++;
+        }
+
+        int blockSize = 1 << order;
+        allocatedOrder[block] = order;
+        requestedSize[block] = size;
+        freeTotal -= blockSize;
+        internalWords += blockSize - size;
+        peakInternalWords = max(peakInternalWords, internalWords);
+        requestedTotal += size;
+        roundedTotal += blockSize;
+        return block;
+    }
+
+    void release(int address) {
+        if (address < 0 || address >= memorySize || allocatedOrder[address] < 0) {
+            return;
+        }
+        int order = allocatedOrder[address];
+        freeTotal += 1 << order;
+        internalWords -= (1 << order) - requestedSize[address];
+        allocatedOrder[address] = -1;
+
+        // merge with the buddy while it is free and of the same order
+        while (order < maxOrder) {
+            int buddy = address ^ (1 << order);
+            if (buddy + (1 << order) > memorySize || freeOrder[buddy] != order) {
+                break;
+            }
+            removeFreeBlock(buddy);
+            address = min(address, buddy);
+            order++;
+            merges++;
+        }
+        insertFreeBlock(address, order);
+    }
+
+    int largestFreeBlock() const {
+        for (int order = maxOrder; order >= 0; order--) {
+            if (freeLists[order] != -1) {
+                return 1 << order;
+            }
+        }
+        return 0;
+    }
+
+    int freeWords() const {
+        return freeTotal;
+    }
+
+    int freeBlockCount() const {
+        return freeCount;
+    }
+
+    bool coalescesOnRelease() const {
+        return true;
+    }
+
+    // walks the blocks in address order; neighbouring free blocks that are
+    // not buddies form one hole, which first fit could use as a whole
+    int firstFitAddress(int size) const {
+        int holeStart = 0;
+        int address = 0;
+        while (address < memorySize) {
+            int order = (freeOrder[address] >= 0) ? freeOrder[address] : allocatedOrder[address];
+            if (order < 0) {
+                break; // the unused tail of memory that is not a power of two
+            }
+            if (freeOrder[address] < 0) {
+                holeStart = address + (1 << order);
+            } else if (address + (1 << order) - holeStart >= size) {
+                return holeStart;
+            }
+            address += 1 << order;
+        }
+        return -1;
+    }
+
+    int roundedSize(int size) const {
+        int order = 0;
+        while ((1 << order) < size) {
+            order++;
+        }
+        return 1 << order;
+    }
+
+    // the block also has to start at a multiple of its size
+    bool fitsInRange(int start, int end, int size) const {
+        int blockSize = roundedSize(size);
+        int first = (start + blockSize - 1) / blockSize * blockSize;
+        return first + blockSize <= end;
+    }
+
+    void printStatistics() const {
+        cout << "Buddy splits: " << splits << ". Buddy merges: " << merges << "." << endl;
+        cout << "Internal fragmentation: "
+             << (roundedTotal > 0 ? 100.0 * (roundedTotal - requestedTotal) / roundedTotal : 0.0)
+             << "% of allocated words (peak " << peakInternalWords << " words unused inside blocks)." << endl;
+    }
+
+private:
+    void insertFreeBlock(int start, int order) {
+        freeOrder[start] = order;
+        prevFree[start] = -1;
+        nextFree[start] = freeLists[order];
+        if (freeLists[order] != -1) {
+            prevFree[freeLists[order]] = start;
+        }
+        freeLists[order] = start;
+        freeCount++;
+    }
+
+    void removeFreeBlock(int start) {
+        int order = freeOrder[start];
+        if (prevFree[start] != -1) {
+            nextFree[prevFree[start]] = nextFree[start];
+        } else {
+            freeLists[order] = nextFree[start];
+        }
+        if (nextFree[start] != -1) {
+            prevFree[nextFree[start]] = prevFree[start];
+        }
+        freeOrder[start] = -1;
+        freeCount--;
+    }
+
+    int memorySize;
+    int maxOrder;                  // largest block is 2^maxOrder words
+    vector<int> freeLists;         // head of the free list of each order (-1 if empty)
+    vector<signed char> freeOrder; // at a free block's first word: its order, else -1
+    vector<signed char> allocatedOrder; // at an allocated block's first word: its order, else -1
+    vector<int> requestedSize;     // at an allocated block's first word: words asked for
+    vector<int> nextFree;          // free list links, kept at a free block's first word
+    vector<int> prevFree;
+    int freeTotal;                 // free words in all blocks
+    int freeCount;                 // number of free blocks
+    long long splits;              // blocks split in half
+    long long merges;              // buddy pairs merged
+    long long internalWords;       // words allocated but not asked for, right now
+    long long peakInternalWords;
+    long long requestedTotal;      // words asked for over all allocations
+    long long roundedTotal;        // words handed out over all allocations
+};
+
+// occupancy bitmap allocator for very large memories
+// one bit per word of mainMemory (1 = used), packed 64 to a bitmap word;
+// allocate is first fit and finds free runs a bitmap word at a time with
+// count-trailing-zeros, and with AVX2 it skips or extends runs 256 bits at
+// a time. words from usedEnd on are known to be free, so scans stop there
+class BitmapAllocator : public MemoryAllocator {
+public:
+    BitmapAllocator(int memorySize) :
+        memorySize(memorySize), words((memorySize + 63) / 64), bitmap(words, 0),
+        paddingBits(0), firstFreeWord(0), usedEnd(0), freeTotal(memorySize),
+        largestCache(memorySize), largestDirty(false) {
+        // bits past the end of memory count as used so no run crosses the end
+        if (memorySize % 64 != 0) {
+            paddingBits = ~0ULL << (memorySize % 64);
+            bitmap[words - 1] = paddingBits;
+        }
+    }
+
+    string name() const {
+        return "bitmap";
+    }
+
+    int allocate(int processID, int size) {
+        (void)processID; // blocks are looked up by address, not owner
+        if (size <= 0 || size > freeTotal) {
+            return -1;
+        }
+        int longest = 0;
+        int start = findFreeRun(size, longest);
+        if (start == -1) {
+            return -1; // no suitable block was found
+        }
+
+        markRange(start, size, true);
+        allocatedSizes[start] = size;
+        freeTotal -= size;
+        usedEnd = max(usedEnd, (start + size - 1) / 64 + 1);
+        while (firstFreeWord < words && bitmap[firstFreeWord] == ~0ULL) {
+            firstFreeWord++;
+        }
+        largestDirty = true;
+        return start;
+    }
+
+    void release(int address) {
+        unordered_map<int, int>::iterator blockIt = allocatedSizes.find(address);
+        if (blockIt == allocatedSizes.end()) {
+            return;
+        }
+        markRange(address, blockIt->second, false);
+        freeTotal += blockIt->second;
+        allocatedSizes.erase(blockIt);
+
+        firstFreeWord = min(firstFreeWord, address / 64);
+        while (usedEnd > 0 && (bitmap[usedEnd - 1] & ~paddingFor(usedEnd - 1)) == 0) {
+            usedEnd--;
+        }
+        largestDirty = true;
+    }
+
+    int largestFreeBlock() const {
+        // a full scan, so only redo it after memory changed
+        if (largestDirty) {
+            int longest = 0;
+            findFreeRun(INT_MAX, longest);
+            largestCache = longest;
+            largestDirty = false;
+        }
+        return largestCache;
+    }
+
+    int freeWords() const {
+        return freeTotal;
+    }
+
+    // a hole starts at every free bit whose lower neighbour is used
+    int freeBlockCount() const {
+        int holes = 0;
+        unsigned long long carry = 0; // top free bit of the previous word
+        for (int w = 0; w < words; w++) {
+            unsigned long long freeBits = ~bitmap[w];
+            holes += __builtin_popcountll(freeBits & ~((freeBits << 1) | carry));
+            carry = freeBits >> 63;
+        }
+        return holes;
+    }
+
+    bool coalescesOnRelease() const {
+        return true;
+    }
+
+    int firstFitAddress(int size) const {
+        int longest = 0;
+        return findFreeRun(size, longest);
+    }
+
+    bool canRelocate() const {
+        return true;
+    }
+
+    bool allocateAt(int processID, int address, int size) {
+        (void)processID; // blocks are looked up by address, not owner
+        if (address < 0 || size <= 0 || address + size > memorySize) {
+            return false;
+        }
+        // every bit of the range must be clear
+        for (int w = address / 64; w <= (address + size - 1) / 64; w++) {
+            if (bitmap[w] & rangeMask(w, address, size)) {
+                return false;
+            }
+        }
+
+        markRange(address, size, true);
+        allocatedSizes[address] = size;
+        freeTotal -= size;
+        usedEnd = max(usedEnd, (address + size - 1) / 64 + 1);
+        while (firstFreeWord < words && bitmap[firstFreeWord] == ~0ULL) {
+            firstFreeWord++;
+        }
+        largestDirty = true;
+        return true;
+    }
+
+private:
+    // padding bits of bitmap word w (only the last word has any)
+    unsigned long long paddingFor(int w) const {
+        return (w == words - 1) ? paddingBits : 0;
+    }
+
+    // start of the first run of at least 'size' free words, or -1;
+    // 'longest' gets the longest run seen on the way (all of them on a miss)
+    int findFreeRun(int size, int& longest) const {
+        int runStart = 0;
+        int runLength = 0;
+        int w = min(firstFreeWord, usedEnd);
+        while (w < usedEnd) {
+#ifdef __AVX2__
+            // four bitmap words at once: skip them if all used, or add them to
+            // the current run if all free
+            if (w + 4 <= usedEnd) {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&bitmap[w]));
+                if (_mm256_testc_si256(chunk, _mm256_set1_epi64x(-1))) {
+                    runLength = 0;
+                    w += 4;
+                    continue;
+                }
+                if (runLength > 0 && _mm256_testz_si256(chunk, chunk)) {
+                    runLength += 256;
+                    longest = max(longest, runLength);
+                    if (runLength >= size) {
+                        return runStart;
+                    }
+                    w += 4;
+                    continue;
+                }
+            }
+#endif
+            unsigned long long freeBits = ~bitmap[w];
+            if (freeBits == 0) {
+                runLength = 0;
+                w++;
+                continue;
+            }
+
+            // walk the free runs inside this word
+            int bit = 0;
+            while (bit < 64) {
+                unsigned long long rest = freeBits >> bit;
+                if (rest == 0) {
+                    runLength = 0; // the rest of the word is used
+                    break;
+                }
+                int usedBits = __builtin_ctzll(rest);
+                if (usedBits > 0) {
+                    runLength = 0;
+                    bit += usedBits;
+                    rest >>= usedBits;
+                }
+                if (runLength == 0) {
+                    runStart = w * 64 + bit;
+                }
+                // shifted in zeros turn into used bits, so this stops at the word end
+                int freeBitsHere = (~rest == 0) ? 64 : __builtin_ctzll(~rest);
+                runLength += freeBitsHere;
+                bit += freeBitsHere;
+                longest = max(longest, runLength);
+                if (runLength >= size) {
+                    return runStart;
+                }
+            }
+            w++;
+        }
+
+        // everything from usedEnd to the end of memory is free
+        if (usedEnd < words) {
+            if (runLength == 0) {
+                runStart = usedEnd * 64;
+            }
+            runLength += memorySize - usedEnd * 64;
+            longest = max(longest, runLength);
+            if (runLength >= size) {
+                return runStart;
+            }
+        }
+        return -1;
+    }
+
+    // the bits of bitmap word w that fall inside words [start, start + length)
+    unsigned long long rangeMask(int w, int start, int length) const {
+        int low = (w == start / 64) ? start % 64 : 0;
+        int high = (w == (start + length - 1) / 64) ? (start + length - 1) % 64 : 63;
+        return (high - low == 63) ? ~0ULL : (((1ULL << (high - low + 1)) - 1) << low);
+    }
+
+    // sets (used) or clears (free) the bits of words [start, start + length)
+    void markRange(int start, int length, bool used) {
+        for (int w = start / 64; w <= (start + length - 1) / 64; w++) {
+            if (used) {
+                bitmap[w] |= rangeMask(w, start, length);
+            } else {
+                bitmap[w] &= ~rangeMask(w, start, length);
+            }
+        }
+    }
+
+    int memorySize;
+    int words;                         // bitmap words (64 memory words each)
+    vector<unsigned long long> bitmap; // bit i of word w is memory word w * 64 + i
+    unsigned long long paddingBits;    // bits of the last word past the end of memory
+    int firstFreeWord;                 // every bitmap word before this one is full
+    int usedEnd;                       // every bitmap word from here on is free
+    int freeTotal;                     // free words
+    unordered_map<int, int> allocatedSizes; // start address -> size of each allocated block
+    mutable int largestCache;          // largest free run as of the last scan
+    mutable bool largestDirty;         // memory changed since that scan
+};
+
+// the allocator the simulator is running with
+MemoryAllocator* memoryAllocator = NULL;
+
+// - HELPER FUNCTION
+// tells the fragmentation tracker (if it is on) that memory changed
+// size > 0 means [start, start + size) was allocated, size < 0 that it was freed
+void trackFragmentation(int start, int size) {
+    if (!fragmentationFile.is_open()) {
+        return;
+    }
+    sampleFragmentation(globalClock);
+    // a rounded up block leaves no hole behind the words asked for
+    if (size > 0) {
+        fragmentationTracker.allocated(start, memoryAllocator->roundedSize(size));
+    } else {
+        fragmentationTracker.freed(start, memoryAllocator->roundedSize(-size));
+    }
+}
+
+// placement check (--tlsf-compat): the first fit address of the latest
+// allocation and how many loads were placed somewhere else
+int lastFirstFitAddress = -1;
+int placementDifferences = 0;
+
+// allocation trace (--trace-out)
+// the file starts with the tag "P3AT", a format version and the memory size
+// (4 byte ints), followed by one 12 byte record per allocator event
+// only allocations that succeeded are recorded, a replay decides for itself
+// whether they fit. blocks moved by compaction are not traced
+struct TraceRecord {
+    int clock;     // globalClock at the event
+    int processID; // process the event belongs to
+    int size;      // words allocated, or TRACE_FREE / TRACE_COALESCE
+};
+const int TRACE_VERSION = 1;
+const int TRACE_FREE = 0;
+const int TRACE_COALESCE = -1;
+ofstream traceFile;
+long long tracedEvents = 0;
+
+// - HELPER FUNCTION
+// appends one event to the allocation trace (if one is being written)
+void traceEvent(int processID, int size) {
+    if (!traceFile.is_open()) {
+        return;
+    }
+    TraceRecord record;
+    record.clock = globalClock;
+    record.processID = processID;
+    record.size = size;
+    traceFile.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    tracedEvents++;
+}
+
+// - HELPER FUNCTION
+// creates the allocator named on the command line
+// returns NULL for an unknown name
+MemoryAllocator* createAllocator(const string& allocatorName, int memorySize) {
+    if (allocatorName == "first-fit") return new ListAllocator(memorySize, FIRST_FIT);
+    if (allocatorName == "next-fit") return new ListAllocator(memorySize, NEXT_FIT);
+    if (allocatorName == "best-fit") return new ListAllocator(memorySize, BEST_FIT);
+    if (allocatorName == "worst-fit") return new ListAllocator(memorySize, WORST_FIT);
+    if (allocatorName == "indexed") return new IndexedAllocator(memorySize);
+    if (allocatorName == "tlsf") return new TLSFAllocator(memorySize);
+    if (allocatorName == "buddy") return new BuddyAllocator(memorySize);
+    if (allocatorName == "bitmap") return new BitmapAllocator(memorySize);
+    return NULL;
+}
+
+// one job of the synthetic allocator benchmark workload
+struct BenchJob {
+    int size;     // words the job needs
+    int lifetime; // ticks the job stays in memory once loaded
+};
+
+// - HELPER FUNCTION
+// replays one synthetic job workload against one allocator
+// every tick one job arrives, finished jobs are freed, and jobs are then
+// loaded from the head of a FIFO queue (with a coalesce retry) like
+// loadJobsToMemory does; allocate() calls are timed individually
+void benchmarkAllocator(MemoryAllocator* allocator, const vector<BenchJob>& jobs) {
+    multimap<long long, int> running; // end tick -> start address
+    size_t nextArrival = 0;           // next job to arrive
+    size_t queueHead = 0;             // first job still waiting for memory
+    long long tick = 0;
+    long long allocCalls = 0;
+    long long failedCalls = 0;
+    double allocNanos = 0.0;
+    double fragmentationSum = 0.0;
+    long long fragmentationSamples = 0;
+    long long waitTicks = 0;
+    long long tooLarge = 0;           // jobs that did not fit into empty memory
+    vector<long long> arrivalTick(jobs.size());
+
+    while (queueHead < jobs.size() || !running.empty()) {
+        // one new job per tick
+        if (nextArrival < jobs.size()) {
+            arrivalTick[nextArrival] = tick;
+            nextArrival++;
+        }
+
+        // release jobs whose time is up
+        while (!running.empty() && running.begin()->first <= tick) {
+            allocator->release(running.begin()->second);
+            running.erase(running.begin());
+        }
+
+        // load from the head of the queue until one does not fit
+        while (queueHead < nextArrival) {
+            const BenchJob& job = jobs[queueHead];
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            int address = allocator->allocate(static_cast<int>(queueHead), job.size);
+            if (address == -1 && !allocator->coalescesOnRelease()) {
+                allocator->coalesce();
+                address = allocator->allocate(static_cast<int>(queueHead), job.size);
+                allocCalls++;
+            }
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            allocNanos += chrono::duration<double, nano>(end - start).count();
+            allocCalls++;
+            if (address == -1 && running.empty()) {
+                // nothing left to free, so this job never fits: skip it
+                tooLarge++;
+                queueHead++;
+                continue;
+            }
+            if (address == -1) {
+                failedCalls++;
+                break;
+            }
+            running.insert(make_pair(tick + job.lifetime, address));
+            waitTicks += tick - arrivalTick[queueHead];
+            queueHead++;
+        }
+
+        // sample external fragmentation: how much free memory is not in the largest hole
+        int freeTotal = allocator->freeWords();
+        if (freeTotal > 0) {
+            fragmentationSum += 1.0 - static_cast<double>(allocator->largestFreeBlock()) / freeTotal;
+            fragmentationSamples++;
+        }
+        tick++;
+    }
+
+    cout << allocator->name() << ": "
+         << (allocCalls > 0 ? allocNanos / allocCalls : 0.0) << " ns per allocation, "
+         << failedCalls << " failed loads, "
+         << (fragmentationSamples > 0 ? 100.0 * fragmentationSum / fragmentationSamples : 0.0)
+         << "% external fragmentation, "
+         << (1000.0 * jobs.size() / tick) << " jobs per 1000 ticks, "
+         << (static_cast<double>(waitTicks) / jobs.size()) << " ticks average wait." << endl;
+    if (tooLarge > 0) {
+        cout << allocator->name() << ": " << tooLarge << " jobs larger than memory were skipped." << endl;
+    }
+    allocator->printStatistics();
+}
+
+// - HELPER FUNCTION
+// replays a recorded allocation trace against one allocator
+// frees go to wherever this allocator put the process; an allocation that
+// does not fit here (after a coalesce retry) is counted and its free skipped
+void replayAllocatorTrace(MemoryAllocator* allocator, int memorySize, const vector<TraceRecord>& records) {
+    unordered_map<int, int> addressOf; // process ID -> start address in this replay
+    long long allocCalls = 0;
+    long long freeCalls = 0;
+    long long failedAllocations = 0;
+    double allocNanos = 0.0;
+    double freeNanos = 0.0;
+    double fragmentationSum = 0.0;
+    long long fragmentationSamples = 0;
+    int peakUsed = 0;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const TraceRecord& record = records[i];
+        if (record.size == TRACE_COALESCE) {
+            allocator->coalesce();
+            continue;
+        }
+        if (record.size == TRACE_FREE) {
+            unordered_map<int, int>::iterator it = addressOf.find(record.processID);
+            if (it == addressOf.end()) {
+                continue; // its allocation failed in this replay
+            }
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            allocator->release(it->second);
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            freeNanos += chrono::duration<double, nano>(end - start).count();
+            freeCalls++;
+            addressOf.erase(it);
+        } else {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            int address = allocator->allocate(record.processID, record.size);
+            if (address == -1 && !allocator->coalescesOnRelease()) {
+                allocator->coalesce();
+                address = allocator->allocate(record.processID, record.size);
+                allocCalls++;
+            }
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            allocNanos += chrono::duration<double, nano>(end - start).count();
+            allocCalls++;
+            if (address == -1) {
+                failedAllocations++;
+                continue;
+            }
+            addressOf[record.processID] = address;
+            peakUsed = max(peakUsed, memorySize - allocator->freeWords());
+        }
+
+        // sample external fragmentation after every allocation and free
+        int freeTotal = allocator->freeWords();
+        if (freeTotal > 0) {
+            fragmentationSum += 1.0 - static_cast<double>(allocator->largestFreeBlock()) / freeTotal;
+            fragmentationSamples++;
+        }
+    }
+
+    cout << allocator->name() << ": "
+         << (allocCalls > 0 ? allocNanos / allocCalls : 0.0) << " ns per allocation, "
+         << (freeCalls > 0 ? freeNanos / freeCalls : 0.0) << " ns per free, "
+         << failedAllocations << " allocations did not fit, "
+         << (fragmentationSamples > 0 ? 100.0 * fragmentationSum / fragmentationSamples : 0.0)
+         << "% external fragmentation, " << peakUsed << " words peak use." << endl;
+    allocator->printStatistics();
+}
+
+// - HELPER FUNCTION
+// reads an allocation trace written with --trace-out
+// returns false if the file is missing or not a trace
+bool readAllocationTrace(const string& fileName, int& memorySize, vector<TraceRecord>& records) {
+    ifstream input(fileName.c_str(), ios::binary);
+    char tag[4];
+    int version = 0;
+    if (!input.read(tag, 4) || string(tag, 4) != "P3AT" ||
+        !input.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != TRACE_VERSION ||
+        !input.read(reinterpret_cast<char*>(&memorySize), sizeof(memorySize)) || memorySize <= 0) {
+        return false;
+    }
+    TraceRecord record;
+    while (input.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        records.push_back(record);
+    }
+    return true;
+}
+
+// - HELPER FUNCTION
+// runs the allocator benchmark for a comma separated list of allocator names
+// ("placement" stands for the four list placement policies)
+// all allocators see exactly the same workload
+int runAllocatorBenchmark(const string& allocatorList) {
+    string names = (allocatorList == "placement") ? "first-fit,next-fit,best-fit,worst-fit" : allocatorList;
+
+    // replay a recorded trace, in the memory size it was recorded with
+    if (!benchTraceName.empty()) {
+        int traceMemory = 0;
+        vector<TraceRecord> records;
+        if (!readAllocationTrace(benchTraceName, traceMemory, records)) {
+            cerr << "Cannot read allocation trace " << benchTraceName << endl;
+            return 1;
+        }
+        cout << "Allocator trace replay: " << records.size() << " events from " << benchTraceName
+             << " in " << traceMemory << " words of memory." << endl;
+
+        stringstream nameStream(names);
+        string name;
+        while (getline(nameStream, name, ',')) {
+            MemoryAllocator* allocator = createAllocator(name, traceMemory);
+            if (allocator == NULL) {
+                cerr << "Unknown allocator: " << name << endl;
+                return 1;
+            }
+            replayAllocatorTrace(allocator, traceMemory, records);
+            delete allocator;
+        }
+        return 0;
+    }
+
+    // build the workload once
+    mt19937 benchRandom(benchSeed);
+    uniform_int_distribution<int> sizeDistribution(benchMinSize, benchMaxSize);
+    uniform_int_distribution<int> lifeDistribution(benchMinLife, benchMaxLife);
+    vector<BenchJob> jobs(benchJobs);
+    for (int i = 0; i < benchJobs; i++) {
+        jobs[i].size = sizeDistribution(benchRandom);
+        jobs[i].lifetime = lifeDistribution(benchRandom);
+    }
+
+    // the same workload against every allocator at every memory size
+    for (size_t i = 0; i < benchMemorySizes.size(); i++) {
+        int benchMemory = benchMemorySizes[i];
+        cout << "Allocator benchmark: " << benchJobs << " jobs of " << benchMinSize << "-" << benchMaxSize
+             << " words in " << benchMemory << " words of memory." << endl;
+
+        stringstream nameStream(names);
+        string name;
+        while (getline(nameStream, name, ',')) {
+            MemoryAllocator* allocator = createAllocator(name, benchMemory);
+            if (allocator == NULL) {
+                cerr << "Unknown allocator: " << name << endl;
+                return 1;
+            }
+            benchmarkAllocator(allocator, jobs);
+            delete allocator;
+        }
+    }
+    return 0;
+}
+
+// - HELPER FUNCTION
+// demand paging: true if one more process may pin its PCB page
+// an instruction needs up to FAULT_RESERVE_FRAMES pages besides page 0, and
+// every admitted process keeps room for that many, so a fault always finds
+// a frame that is not pinned or kept for another process's next instruction
+bool canPinFrame() {
+    return (pinnedFrames + 1) * (1 + FAULT_RESERVE_FRAMES) <= static_cast<int>(frameRow.size());
+}
+
+// - HELPER FUNCTION
+// demand paging: the frames load control counts for a process
+// until a whole window of references was seen, a process is assumed to
+// need at least its PCB page and the pages of one instruction
+int workingSetCharge(int row) {
+    const WorkingSet& workingSet = processTable.workingSet[row];
+    if (workingSet.filled < workingSetWindow) {
+        return max(workingSet.size, 1 + FAULT_RESERVE_FRAMES);
+    }
+    return workingSet.size;
+}
+
+// - HELPER FUNCTION
+// demand paging: true if a new job may be admitted
+// with load control the job's assumed working set has to fit next to the
+// working sets of the active processes
+bool canAdmitDemandJob() {
+    if (!canPinFrame()) {
+        return false;
+    }
+    return !loadControl || activeWorkingSet + 1 + FAULT_RESERVE_FRAMES <= static_cast<long long>(frameRow.size());
+}
+
+// - HELPER FUNCTION
+// demand paging: sets up the page table of a new process with only page 0
+// (which holds the PCB) resident and pinned; every other page comes in on
+// its first use. returns the physical address of page 0, or -1
+int allocateDemandPages(int row, int size, int pages) {
+    if (!canAdmitDemandJob() || freeFrames.empty()) {
+        return -1;
+    }
+    vector<int>& table = processTable.pageTable[row];
+    table.assign(pages, -1);
+    processTable.pageSlot[row].assign(pages, -1);
+    WorkingSet& workingSet = processTable.workingSet[row];
+    workingSet.window.assign(workingSetWindow, 0);
+    workingSet.pageCount.assign(pages, 0);
+    activeWorkingSet += workingSetCharge(row);
+    activeProcesses++;
+    demandStats.peakWorkingSet = max(demandStats.peakWorkingSet, activeWorkingSet);
+    int frame = freeFrames.back();
+    freeFrames.pop_back();
+    table[0] = frame;
+    frameRow[frame] = row;
+    framePage[frame] = 0;
+    frameDirty[frame] = 0;
+    framePinned[frame] = 1;
+    pinnedFrames++;
+
+    pagingStats.framesInUse++;
+    pagingStats.peakFramesInUse = max(pagingStats.peakFramesInUse, pagingStats.framesInUse);
+    pagingStats.pageTableEntries += pages;
+    pagingStats.peakPageTableEntries = max(pagingStats.peakPageTableEntries, pagingStats.pageTableEntries);
+    pagingStats.unusedWords += (pages << pageShift) - size;
+    pagingStats.peakUnusedWords = max(pagingStats.peakUnusedWords, pagingStats.unusedWords);
+
+    int pcbAddress = frame << pageShift;
+    processTable.block[row] = MemoryBlock(processTable.processID[row], pcbAddress, size);
+    processTable.rowAtAddress[pcbAddress] = row;
+    updateMemoryUsage(pageSize);
+    traceEvent(processTable.processID[row], size);
+    return pcbAddress;
+}
+
+// - HELPER FUNCTION
+// paged memory: gives a process enough frames for 'size' words
+// returns the physical address of page 0 (where the PCB goes), or -1
+int allocatePages(int row, int size) {
+    int pages = (size + pageSize - 1) >> pageShift;
+    if (pageReplacer != NULL) {
+        return allocateDemandPages(row, size, pages);
+    }
+    if (pages > static_cast<int>(freeFrames.size())) {
+        return -1; // frames do not have to be contiguous, so only the count matters
+    }
+    vector<int>& table = processTable.pageTable[row];
+    table.resize(pages);
+    for (int page = 0; page < pages; page++) {
+        table[page] = freeFrames.back();
+        freeFrames.pop_back();
+        frameRefs[table[page]] = 1;
+    }
+
+    pagingStats.framesInUse += pages;
+    pagingStats.peakFramesInUse = max(pagingStats.peakFramesInUse, pagingStats.framesInUse);
+    pagingStats.pageTableEntries += pages;
+    pagingStats.peakPageTableEntries = max(pagingStats.peakPageTableEntries, pagingStats.pageTableEntries);
+    pagingStats.unusedWords += (pages << pageShift) - size;
+    pagingStats.peakUnusedWords = max(pagingStats.peakUnusedWords, pagingStats.unusedWords);
+
+    int pcbAddress = table[0] << pageShift;
+    processTable.block[row] = MemoryBlock(processTable.processID[row], pcbAddress, size);
+    processTable.rowAtAddress[pcbAddress] = row;
+    updateMemoryUsage(pages << pageShift);
+    traceEvent(processTable.processID[row], size);
+    return pcbAddress;
+}
+
+// - HELPER FUNCTION
+// segmented memory: FNV-1a hash of the opcodes and parameters of a job
+unsigned long long hashWords(const vector<int>& words) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < words.size(); i++) {
+        unsigned int word = static_cast<unsigned int>(words[i]);
+        for (int byte = 0; byte < 4; byte++) {
+            hash = (hash ^ ((word >> (byte * 8)) & 0xff)) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+// - HELPER FUNCTION
+// segmented memory: adds to the words shared by more than one process
+void changeSharedWords(long long change) {
+    segmentStats.wordsSaved += change;
+    segmentStats.peakWordsSaved = max(segmentStats.peakWordsSaved, segmentStats.wordsSaved);
+}
+
+// - HELPER FUNCTION
+// segmented memory: takes a code segment out of the hash index, so no
+// later job shares it (it is about to change or to be freed)
+void unlistCodeSegment(int base) {
+    CodeSegment& segment = codeSegments[base];
+    if (!segment.listed) {
+        return;
+    }
+    pair<unordered_multimap<unsigned long long, int>::iterator,
+         unordered_multimap<unsigned long long, int>::iterator> range = codeSegmentsByHash.equal_range(segment.hash);
+    for (unordered_multimap<unsigned long long, int>::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == base) {
+            codeSegmentsByHash.erase(it);
+            break;
+        }
+    }
+    segment.listed = false;
+    vector<int>().swap(segment.words);
+}
+
+// - HELPER FUNCTION
+// segmented memory: gives a job a data segment and a code segment, sharing
+// a code segment already in memory if one holds the same words
+// the image keeps the size it would have in one block; if the code is
+// longer than the memory the job asked for, the data segment keeps the PCB
+// returns the address of the data segment (where the PCB goes), or -1
+int allocateSegments(int row, int size) {
+    int processID = processTable.processID[row];
+    const vector<int>& code = processTable.codeImage[row];
+    int codeLimit = code.size();
+    int dataLimit = size - min(codeLimit, size - 10);
+
+    // look for a code segment with the same words
+    unsigned long long hash = hashWords(code);
+    int codeBase = -1;
+    pair<unordered_multimap<unsigned long long, int>::iterator,
+         unordered_multimap<unsigned long long, int>::iterator> range = codeSegmentsByHash.equal_range(hash);
+    for (unordered_multimap<unsigned long long, int>::iterator it = range.first;
+         codeLimit > 0 && it != range.second; ++it) {
+        if (codeSegments[it->second].words == code) {
+            codeBase = it->second;
+            break;
+        }
+    }
+    bool shared = (codeBase != -1);
+
+    int dataBase = memoryAllocator->allocate(processID, dataLimit);
+    if (dataBase == -1) {
+        return -1;
+    }
+    if (!shared && codeLimit > 0) {
+        codeBase = memoryAllocator->allocate(processID, codeLimit);
+        if (codeBase == -1) {
+            memoryAllocator->release(dataBase);
+            return -1;
+        }
+        CodeSegment& segment = codeSegments[codeBase];
+        segment.refs = 0;
+        segment.hash = hash;
+        segment.listed = true;
+        segment.words = code;
+        codeSegmentsByHash.insert(make_pair(hash, codeBase));
+        updateMemoryUsage(codeLimit);
+        trackFragmentation(codeBase, codeLimit);
+        segmentStats.liveSegments++;
+        segmentStats.peakLiveSegments = max(segmentStats.peakLiveSegments, segmentStats.liveSegments);
+    }
+    if (shared) {
+        segmentStats.sharedLoads++;
+        segmentStats.wordsNotLoaded += codeLimit;
+        changeSharedWords(codeLimit);
+        // a job whose code would not have fit as well only got in by sharing it
+        if (memoryAllocator->largestFreeBlock() < codeLimit) {
+            segmentStats.sharedAdmissions++;
+        }
+    }
+    if (codeLimit > 0) {
+        codeSegments[codeBase].refs++;
+    }
+    segmentStats.loads++;
+
+    SegmentTable& segments = processTable.segments[row];
+    segments.code.base = codeBase;
+    segments.code.limit = codeLimit;
+    segments.data.base = dataBase;
+    segments.data.limit = dataLimit;
+    DataSegment& data = dataSegments[dataBase];
+    data.refs = 1;
+    data.holdsPCB = true;
+    data.limit = dataLimit;
+    processTable.block[row] = MemoryBlock(processID, dataBase, size);
+    processTable.rowAtAddress[dataBase] = row;
+    updateMemoryUsage(dataLimit);
+    trackFragmentation(dataBase, dataLimit);
+    return dataBase;
+}
+
+// allocates memory for a process
+// this asks the active allocator for a block of sufficient size and records it
+int allocateMemory(int row, int size) {
+    if (pageSize > 0) {
+        return allocatePages(row, size);
+    }
+    if (segmentedMemory) {
+        return allocateSegments(row, size);
+    }
+    int processID = processTable.processID[row];
+    // remember where first fit would have put the block, for --tlsf-compat
+    if (placementCheck) {
+        lastFirstFitAddress = memoryAllocator->firstFitAddress(size);
+    }
+
+    int allocatedAddress = memoryAllocator->allocate(processID, size);
+    if (allocatedAddress == -1) {
+        return -1; // no suitable block was found
+    }
+
+    // store the block for quick access later; its PCB will start at its first word
+    processTable.block[row] = MemoryBlock(processID, allocatedAddress, size);
+    processTable.rowAtAddress[allocatedAddress] = row;
+    updateMemoryUsage(size);
+    traceEvent(processID, size);
+    trackFragmentation(allocatedAddress, size);
+    return allocatedAddress;
+}
+
+// translateAddress result for a page that is out in the page file
+const int PAGE_NOT_RESIDENT = -2;
+
+// - HELPER FUNCTION
+// segmented memory: turns an image address into a mainMemory index
+// the image is laid out as in one block (PCB, opcodes and parameters, the
+// rest); the code part is in the code segment, the other words in the data
+// segment. the PCB is where the process's block starts, which is the data
+// segment unless the process was forked or copied a shared data segment
+inline int translateSegmented(int row, int address) {
+    const SegmentTable& segments = processTable.segments[row];
+    if (address < 0) {
+        return -1;
+    }
+    if (address < 10) {
+        return processTable.block[row].startAddress + address; // the PCB
+    }
+    if (address - 10 < segments.code.limit) {
+        return segments.code.base + address - 10;
+    }
+    int offset = address - segments.code.limit;
+    return (offset < segments.data.limit) ? segments.data.base + offset : -1;
+}
+
+// - HELPER FUNCTION
+// turns an address a process uses into a mainMemory index
+// with contiguous blocks addresses are already physical. with paging the
+// page table is looked up, with segments the segment table; -1 means the
+// address is outside the image
+inline int translateAddress(int row, int address, MemoryAccess access) {
+    if (pageSize == 0) {
+        return segmentedMemory ? translateSegmented(row, address) : address;
+    }
+    pagingStats.translations++;
+    const vector<int>& table = processTable.pageTable[row];
+    int page = address >> pageShift;
+    if (address < 0 || page >= static_cast<int>(table.size())) {
+        return -1;
+    }
+    if (table[page] == -1) {
+        return PAGE_NOT_RESIDENT;
+    }
+    int frame = (tlbEntries > 0 && access != OS_ACCESS) ? tlb.lookup(row, page, access) : table[page];
+    return (frame << pageShift) | (address & (pageSize - 1));
+}
+
+// - HELPER FUNCTION
+// reads one word of a page that is out in the page file
+// a page that was never written out has no contents yet and reads as -1
+int readBackingWord(int row, int address) {
+    int slot = processTable.pageSlot[row][address >> pageShift];
+    if (slot == -1) {
+        return -1;
+    }
+    int value = -1;
+    pageFile.seekg((static_cast<long long>(slot) * pageSize + (address & (pageSize - 1))) * sizeof(int));
+    pageFile.read(reinterpret_cast<char*>(&value), sizeof(int));
+    return value;
+}
+
+// - HELPER FUNCTION
+// reads one word of memory on behalf of a process
+// (with lazy scrubbing a stale word reads as -1). a STORE can rewrite the
+// program counter, so instruction fetches go through here as well
+inline int readWord(const vector<int>& mainMemory, int row, int address, MemoryAccess access = OS_ACCESS) {
+    int physical = translateAddress(row, address, access);
+    if (physical == PAGE_NOT_RESIDENT) {
+        return readBackingWord(row, address);
+    }
+    address = physical;
+    if (address < 0) {
+        return -1;
+    }
+    if (lazyScrub && wordEpoch[address] < chunkFreeEpoch[address / SCRUB_CHUNK_WORDS]) {
+        return -1;
+    }
+    return mainMemory[address];
+}
+
+// - HELPER FUNCTION
+// writes one word of memory on behalf of a process and marks it as current
+inline void writeWord(vector<int>& mainMemory, int row, int address, int value,
+                      MemoryAccess access = OS_ACCESS) {
+    address = translateAddress(row, address, access);
+    mainMemory[address] = value;
+    if (lazyScrub) {
+        wordEpoch[address] = scrubEpoch;
+    }
+    if (pageReplacer != NULL && access == DATA_ACCESS) {
+        frameDirty[address >> pageShift] = 1;
+    }
+}
+
+// - HELPER FUNCTION
+// marks words just written in bulk (a placement, copy or swap in) as current
+void stampWords(int start, int length) {
+    if (lazyScrub) {
+        fill(wordEpoch.begin() + start, wordEpoch.begin() + start + length, scrubEpoch);
+    }
+}
+
+// - HELPER FUNCTION
+// bulk scrub: writes -1 into a range of words
+// fill compiles to a vectorized store loop, much faster than word by word
+void fillWords(vector<int>& mainMemory, int start, int length) {
+    fill(mainMemory.begin() + start, mainMemory.begin() + start + length, -1);
+    scrubStats.wordsFilled += length;
+}
+
+// - HELPER FUNCTION
+// scrubs a range of words nobody owns any more
+// eagerly this is a bulk fill. lazily only the chunks completely inside the
+// range are tagged with a new epoch and the partial chunks at the ends are filled
+void scrubFreedWords(vector<int>& mainMemory, int start, int length) {
+    if (length <= 0) {
+        return;
+    }
+    int end = start + length;
+    int firstChunk = (start + SCRUB_CHUNK_WORDS - 1) / SCRUB_CHUNK_WORDS;
+    int lastChunk = end / SCRUB_CHUNK_WORDS; // one past the last whole chunk
+    if (!lazyScrub || firstChunk >= lastChunk) {
+        fillWords(mainMemory, start, length);
+        return;
+    }
+
+    // every word written so far is now older than the tag
+    scrubEpoch++;
+    fill(chunkFreeEpoch.begin() + firstChunk, chunkFreeEpoch.begin() + lastChunk, scrubEpoch);
+    scrubStats.wordsTagged += (lastChunk - firstChunk) * SCRUB_CHUNK_WORDS;
+    fillWords(mainMemory, start, firstChunk * SCRUB_CHUNK_WORDS - start);
+    fillWords(mainMemory, lastChunk * SCRUB_CHUNK_WORDS, end - lastChunk * SCRUB_CHUNK_WORDS);
+}
+
+// - HELPER FUNCTION
+// gives the stale words in a range their -1 for real, before the range is
+// copied somewhere or printed. the select below has no branch in the loop
+// body, so it vectorizes like a plain fill
+void materializeWords(vector<int>& mainMemory, int start, int length) {
+    if (!lazyScrub) {
+        return;
+    }
+    int end = start + length;
+    for (int chunkStart = start; chunkStart < end; ) {
+        int chunk = chunkStart / SCRUB_CHUNK_WORDS;
+        int chunkEnd = min(end, (chunk + 1) * SCRUB_CHUNK_WORDS);
+        unsigned int tag = chunkFreeEpoch[chunk];
+        if (tag != 0) {
+            int stale = 0;
+            for (int i = chunkStart; i < chunkEnd; i++) {
+                stale += (wordEpoch[i] < tag);
+                mainMemory[i] = (wordEpoch[i] < tag) ? -1 : mainMemory[i];
+            }
+            stampWords(chunkStart, chunkEnd - chunkStart);
+            scrubStats.wordsMaterialized += stale;
+        }
+        chunkStart = chunkEnd;
+    }
+}
+
+// - HELPER FUNCTION
+// demand paging: hands out a page file slot, reusing freed ones first
+int allocatePageSlot() {
+    if (!freePageSlots.empty()) {
+        int slot = freePageSlots.back();
+        freePageSlots.pop_back();
+        return slot;
+    }
+    return pageSlotsUsed++;
+}
+
+// - HELPER FUNCTION
+// demand paging: writes one page worth of words into a page file slot
+void writePageSlot(int slot, const int* words) {
+    pageFile.seekp(static_cast<long long>(slot) * pageSize * sizeof(int));
+    pageFile.write(reinterpret_cast<const char*>(words), pageSize * sizeof(int));
+}
+
+// - HELPER FUNCTION
+// demand paging: pushes the page in a frame out of memory
+// the page goes to the page file if a STORE changed it, otherwise the copy
+// already there (or no copy, for a page that was never written) is kept
+// returns true if the page had to be written
+bool evictFrame(vector<int>& mainMemory, int frame) {
+    int row = frameRow[frame];
+    int page = framePage[frame];
+    bool written = frameDirty[frame];
+    if (written) {
+        int& slot = processTable.pageSlot[row][page];
+        if (slot == -1) {
+            slot = allocatePageSlot();
+        }
+        materializeWords(mainMemory, frame << pageShift, pageSize);
+        writePageSlot(slot, &mainMemory[frame << pageShift]);
+        demandStats.pagesOut++;
+    } else {
+        demandStats.cleanDrops++;
+    }
+    processTable.pageTable[row][page] = -1;
+    if (tlbEntries > 0) {
+        tlb.invalidate(processTable.processID[row], page);
+    }
+    frameRow[frame] = -1;
+    frameDirty[frame] = 0;
+    pagingStats.framesInUse--;
+    updateMemoryUsage(-pageSize);
+    return written;
+}
+
+// - HELPER FUNCTION
+// demand paging: brings a page of a process into a frame
+// returns true if the page had to be read from the page file
+bool pageIn(vector<int>& mainMemory, int row, int page, int frame) {
+    int slot = processTable.pageSlot[row][page];
+    int start = frame << pageShift;
+    if (slot == -1) {
+        fillWords(mainMemory, start, pageSize); // never written, nothing to read
+        demandStats.zeroFills++;
+    } else {
+        pageFile.seekg(static_cast<long long>(slot) * pageSize * sizeof(int));
+        pageFile.read(reinterpret_cast<char*>(&mainMemory[start]), pageSize * sizeof(int));
+        demandStats.pagesIn++;
+    }
+    stampWords(start, pageSize);
+
+    processTable.pageTable[row][page] = frame;
+    frameRow[frame] = row;
+    framePage[frame] = page;
+    frameDirty[frame] = 0;
+    framePinned[frame] = 0;
+    pageReplacer->loaded(frame);
+    pagingStats.framesInUse++;
+    pagingStats.peakFramesInUse = max(pagingStats.peakFramesInUse, pagingStats.framesInUse);
+    updateMemoryUsage(pageSize);
+    return slot != -1;
+}
+
+// - HELPER FUNCTION
+// demand paging: lets go of the frames a process kept for its next instruction
+void unlockFrames(int row) {
+    vector<int>& locked = processTable.lockedFrames[row];
+    for (size_t i = 0; i < locked.size(); i++) {
+        frameLocked[locked[i]] = 0;
+    }
+    locked.clear();
+}
+
+// - HELPER FUNCTION
+// demand paging: reads a word of a process wherever it is, without
+// counting a reference (used to find out what the next instruction needs)
+int peekWord(const vector<int>& mainMemory, int row, int address) {
+    const vector<int>& table = processTable.pageTable[row];
+    int page = address >> pageShift;
+    if (address < 0 || page >= static_cast<int>(table.size())) {
+        return -1;
+    }
+    if (table[page] == -1) {
+        return readBackingWord(row, address);
+    }
+    int physical = (table[page] << pageShift) | (address & (pageSize - 1));
+    if (lazyScrub && wordEpoch[physical] < chunkFreeEpoch[physical / SCRUB_CHUNK_WORDS]) {
+        return -1;
+    }
+    return mainMemory[physical];
+}
+
+// - HELPER FUNCTION
+// demand paging: slides a process's working set window over one more page
+// reference (page 0 is not recorded, it is always part of the set)
+void recordPageReference(int row, int page) {
+    if (page == 0) {
+        return;
+    }
+    WorkingSet& workingSet = processTable.workingSet[row];
+    int chargeBefore = workingSetCharge(row);
+    if (workingSet.filled == workingSetWindow) {
+        int oldest = workingSet.window[workingSet.next];
+        if (--workingSet.pageCount[oldest] == 0) {
+            workingSet.size--;
+        }
+    } else {
+        workingSet.filled++;
+    }
+    workingSet.window[workingSet.next] = page;
+    workingSet.next = (workingSet.next + 1) % workingSetWindow;
+    if (workingSet.pageCount[page]++ == 0) {
+        workingSet.size++;
+    }
+    activeWorkingSet += workingSetCharge(row) - chargeBefore;
+    demandStats.peakWorkingSet = max(demandStats.peakWorkingSet, activeWorkingSet);
+}
+
+// - HELPER FUNCTION
+// demand paging: makes every page the next instruction of a process
+// touches (the instruction, its parameters and a LOAD/STORE target)
+// resident. victims come from the replacement policy; the pages are then
+// locked until the instruction runs, so a process waiting for its pages
+// cannot lose them to the next fault
+// returns the IO time the process has to wait (0: it can run right away),
+// or SUSPEND_FOR_LOAD_CONTROL
+int servicePageFaults(vector<int>& mainMemory, const PCB& process, int& firstMissing) {
+    int row = process.tableRow;
+    vector<int>& table = processTable.pageTable[row];
+    int pages[FAULT_RESERVE_FRAMES];
+    int pageCount = 0;
+
+    // the pages of the instruction, its parameters and its target
+    int opcode = peekWord(mainMemory, row, process.programCounter);
+    int paramStart = process.dataBase + process.paramOffset;
+    int params = getParameterCount(static_cast<InstructionType>(opcode));
+    int addresses[FAULT_RESERVE_FRAMES] = { process.programCounter, -1, -1, -1 };
+    for (int i = 0; i < params; i++) {
+        addresses[1 + i] = paramStart + i;
+    }
+    if (opcode == STORE || opcode == LOAD) {
+        int target = peekWord(mainMemory, row, paramStart + (opcode == STORE ? 1 : 0));
+        if (target >= 0 && target < process.memoryLimit) {
+            addresses[3] = process.mainMemoryBase + target;
+        }
+    }
+    for (int i = 0; i < FAULT_RESERVE_FRAMES; i++) {
+        int page = addresses[i] >> pageShift;
+        if (addresses[i] < 0 || page >= static_cast<int>(table.size()) ||
+            find(pages, pages + pageCount, page) != pages + pageCount) {
+            continue;
+        }
+        pages[pageCount++] = page;
+    }
+
+    // the common case: everything is there. each page counts as one
+    // reference of the instruction, unless a fault already counted it
+    // before the process had to wait
+    vector<int>& locked = processTable.lockedFrames[row];
+    bool resuming = !locked.empty();
+    firstMissing = -1;
+    for (int i = 0; i < pageCount && firstMissing == -1; i++) {
+        if (table[pages[i]] == -1) {
+            firstMissing = pages[i];
+        }
+    }
+    unlockFrames(row);
+    if (firstMissing == -1) {
+        if (!resuming) {
+            demandStats.references += pageCount;
+            for (int i = 0; i < pageCount; i++) {
+                recordPageReference(row, pages[i]);
+                if (!framePinned[table[pages[i]]]) {
+                    pageReplacer->touched(table[pages[i]]);
+                }
+            }
+        }
+        return 0;
+    }
+    demandStats.faults++;
+    demandStats.references += pageCount;
+    for (int i = 0; i < pageCount; i++) {
+        recordPageReference(row, pages[i]);
+    }
+
+    // with load control a fault while the working sets do not fit
+    // suspends the faulting process (unless it is the only one left)
+    if (loadControl && activeWorkingSet > static_cast<long long>(frameRow.size()) && activeProcesses > 1) {
+        return SUSPEND_FOR_LOAD_CONTROL;
+    }
+
+    // keep the pages that are there while the missing ones come in
+    for (int i = 0; i < pageCount; i++) {
+        int frame = table[pages[i]];
+        if (frame != -1 && !framePinned[frame]) {
+            pageReplacer->touched(frame);
+            frameLocked[frame] = 1;
+            locked.push_back(frame);
+        }
+    }
+
+    int transfers = 0;
+    for (int i = 0; i < pageCount; i++) {
+        int page = pages[i];
+        if (table[page] != -1) {
+            continue;
+        }
+        int frame;
+        if (!freeFrames.empty()) {
+            frame = freeFrames.back();
+            freeFrames.pop_back();
+        } else {
+            frame = pageReplacer->victim(pageKey(process.processID, page));
+            if (frame == -1) {
+                // every evictable frame is kept by processes about to run
+                // (canPinFrame should prevent this); give up ours so one of
+                // them gets through, and try again later
+                unlockFrames(row);
+                return pageFaultTime;
+            }
+            transfers += evictFrame(mainMemory, frame);
+        }
+        transfers += pageIn(mainMemory, row, page, frame);
+        frameLocked[frame] = 1;
+        locked.push_back(frame);
+    }
+
+    // pages that only needed filling cost no IO
+    if (transfers == 0) {
+        unlockFrames(row);
+    }
+    return transfers * pageFaultTime;
+}
+
+// - HELPER FUNCTION
+// demand paging: evicts one page so a new process can have a frame for its
+// PCB page. the frame is scrubbed like any freed frame
+// returns false if there is nothing to evict or the job may not be admitted
+bool evictForAdmission(vector<int>& mainMemory) {
+    if (!canAdmitDemandJob() || !freeFrames.empty()) {
+        return false;
+    }
+    int frame = pageReplacer->victim(-1);
+    if (frame == -1) {
+        return false;
+    }
+    evictFrame(mainMemory, frame);
+    scrubFreedWords(mainMemory, frame << pageShift, pageSize);
+    freeFrames.push_back(frame);
+    return true;
+}
+
+// - HELPER FUNCTION
+// demand paging: places a new image. page 0 (the PCB and the start of the
+// program) goes into the frame it was given; the rest of the program is
+// written to the page file, to be read in when the process touches it
+void storeImageOnDemand(vector<int>& mainMemory, int row, int imageStart, const vector<int>& image) {
+    int imageEnd = imageStart + static_cast<int>(image.size());
+    int address = imageStart;
+    for (; address < imageEnd && address < pageSize; address++) {
+        writeWord(mainMemory, row, address, image[address - imageStart]);
+    }
+
+    vector<int> buffer(pageSize);
+    while (address < imageEnd) {
+        int page = address >> pageShift;
+        int pageStart = page << pageShift;
+        fill(buffer.begin(), buffer.end(), -1);
+        for (; address < imageEnd && address < pageStart + pageSize; address++) {
+            buffer[address - pageStart] = image[address - imageStart];
+        }
+        int slot = allocatePageSlot();
+        writePageSlot(slot, &buffer[0]);
+        processTable.pageSlot[row][page] = slot;
+        demandStats.imagePages++;
+    }
+}
+
+// - HELPER FUNCTION
+// load control: takes a faulting process out of memory while the working
+// sets of the active processes do not fit. its pages go to the page file
+// (the PCB page stays) and it waits until the others leave room for it
+void suspendProcess(vector<int>& mainMemory, int row, int pcbAddress) {
+    vector<int>& table = processTable.pageTable[row];
+    for (size_t page = 1; page < table.size(); page++) {
+        int frame = table[page];
+        if (frame != -1) {
+            pageReplacer->removed(frame);
+            evictFrame(mainMemory, frame);
+            scrubFreedWords(mainMemory, frame << pageShift, pageSize);
+            freeFrames.push_back(frame);
+        }
+    }
+    if (tlbEntries > 0) {
+        tlb.flushProcess(processTable.processID[row]);
+    }
+    activeWorkingSet -= workingSetCharge(row);
+    activeProcesses--;
+    suspendedProcesses.push(pcbAddress);
+    demandStats.suspensions++;
+    cout << "Process " << processTable.processID[row] << " suspended by load control (working set "
+         << processTable.workingSet[row].size << " pages)." << endl;
+}
+
+// - HELPER FUNCTION
+// load control: puts suspended processes back on the ready queue, oldest
+// first, while their working sets fit (or when nothing else is active)
+// returns true if no process is left suspended
+bool resumeSuspendedProcesses(queue<int>& readyQueue) {
+    while (!suspendedProcesses.empty()) {
+        int pcbAddress = suspendedProcesses.front();
+        int row = processTable.rowAt(pcbAddress);
+        if (activeProcesses > 0 &&
+            activeWorkingSet + workingSetCharge(row) > static_cast<long long>(frameRow.size())) {
+            return false;
+        }
+        suspendedProcesses.pop();
+        activeWorkingSet += workingSetCharge(row);
+        activeProcesses++;
+        demandStats.peakWorkingSet = max(demandStats.peakWorkingSet, activeWorkingSet);
+        demandStats.resumes++;
+        cout << "Process " << processTable.processID[row] << " resumed by load control." << endl;
+        readyQueue.push(pcbAddress);
+    }
+    return true;
+}
+
+// - HELPER FUNCTION
+// demand paging: forgets the frames and page file slots of a terminating
+// process (its frames go back to the pool in freeMemory)
+void releaseDemandPages(int row) {
+    unlockFrames(row);
+    activeWorkingSet -= workingSetCharge(row);
+    activeProcesses--;
+    const vector<int>& table = processTable.pageTable[row];
+    for (size_t page = 0; page < table.size(); page++) {
+        int frame = table[page];
+        if (frame != -1) {
+            if (framePinned[frame]) {
+                framePinned[frame] = 0;
+                pinnedFrames--;
+            } else {
+                pageReplacer->removed(frame);
+            }
+            frameRow[frame] = -1;
+            frameDirty[frame] = 0;
+        }
+        int slot = processTable.pageSlot[row][page];
+        if (slot != -1) {
+            freePageSlots.push_back(slot);
+        }
+    }
+    processTable.pageSlot[row].clear();
+}
+
+// - HELPER FUNCTION
+// segmented memory: drops a process's use of its code segment
+// the segment is freed when the last process using it is gone
+void releaseCodeSegment(vector<int>& mainMemory, const Segment& code) {
+    if (code.limit == 0) {
+        return;
+    }
+    CodeSegment& segment = codeSegments[code.base];
+    if (--segment.refs > 0) {
+        changeSharedWords(-code.limit);
+        return;
+    }
+    unlistCodeSegment(code.base);
+    codeSegments.erase(code.base);
+    scrubFreedWords(mainMemory, code.base, code.limit);
+    memoryAllocator->release(code.base);
+    updateMemoryUsage(-code.limit);
+    trackFragmentation(code.base, -code.limit);
+    segmentStats.liveSegments--;
+}
+
+// - HELPER FUNCTION
+// segmented memory: drops a process's use of a data segment block, either
+// as the place of its PCB or of its data. the block is freed once no
+// process uses it either way
+void releaseDataSegment(vector<int>& mainMemory, int base, bool pcb) {
+    DataSegment& segment = dataSegments[base];
+    if (pcb) {
+        segment.holdsPCB = false;
+    } else {
+        segment.refs--;
+    }
+    if (segment.refs > 0 || segment.holdsPCB) {
+        return;
+    }
+    int limit = segment.limit;
+    dataSegments.erase(base);
+    scrubFreedWords(mainMemory, base, limit);
+    memoryAllocator->release(base);
+    updateMemoryUsage(-limit);
+    trackFragmentation(base, -limit);
+}
+
+// - HELPER FUNCTION
+// frees memory that was allocated to a process
+// this marks the memory as available for other processes
+void freeMemory(vector<int>& mainMemory, int row) {
+    // check if this process has an allocated memory block
+    MemoryBlock& block = processTable.block[row];
+    if (block.processID == -1) {
+        return; // process doesn't have any allocated memory
+    }
+    
+    // get the memory block for this process
+    int startAddress = block.startAddress;
+    int size = block.size;
+
+    // paged memory: scrub the frames and put them back in the pool
+    if (pageSize > 0) {
+        vector<int>& table = processTable.pageTable[row];
+        int frames = 0;
+        for (int page = static_cast<int>(table.size()) - 1; page >= 0; page--) {
+            if (table[page] == -1) {
+                continue; // out in the page file (demand paging)
+            }
+            if (pageReplacer == NULL && --frameRefs[table[page]] > 0) {
+                continue; // still used by a forked relative
+            }
+            scrubFreedWords(mainMemory, table[page] << pageShift, pageSize);
+            freeFrames.push_back(table[page]);
+            frames++;
+        }
+        if (pageReplacer != NULL) {
+            releaseDemandPages(row);
+        }
+        pagingStats.framesInUse -= frames;
+        pagingStats.pageTableEntries -= table.size();
+        pagingStats.unusedWords -= (static_cast<int>(table.size()) << pageShift) - size;
+        updateMemoryUsage(-(frames << pageShift));
+        traceEvent(block.processID, TRACE_FREE);
+        if (tlbEntries > 0) {
+            tlb.flushProcess(block.processID);
+        }
+        table.clear();
+        processTable.rowAtAddress.erase(startAddress);
+        block = MemoryBlock();
+        return;
+    }
+    
+    // segmented memory: let go of the PCB, data and code segment blocks
+    // (each one is freed when the last process using it is gone)
+    if (segmentedMemory) {
+        SegmentTable& segments = processTable.segments[row];
+        releaseDataSegment(mainMemory, startAddress, true);
+        releaseDataSegment(mainMemory, segments.data.base, false);
+        releaseCodeSegment(mainMemory, segments.code);
+        segments = SegmentTable();
+        processTable.rowAtAddress.erase(startAddress);
+        block = MemoryBlock();
+        return;
+    }
+    
+    // clear memory by setting all values to -1 (or tag it, with lazy scrubbing)
+    scrubFreedWords(mainMemory, startAddress, size);
+    
+    // give the block back to the allocator
+    memoryAllocator->release(startAddress);
+    updateMemoryUsage(-size);
+    traceEvent(block.processID, TRACE_FREE);
+    trackFragmentation(startAddress, -size);
+    
+    // the process no longer has a block
+    processTable.rowAtAddress.erase(startAddress);
+    block = MemoryBlock();
+}
+
+// merges adjacent free memory blocks to create larger free blocks
+// this helps reduce memory fragmentation
+void coalesceMemory() {
+    if (pageSize > 0) {
+        return; // frames are never combined
+    }
+    memoryAllocator->coalesce();
+    traceEvent(-1, TRACE_COALESCE);
+}
+
+// - HELPER FUNCTION
+// finds the size of the largest free region in memory
+int largestFreeBlock() {
+    if (pageReplacer != NULL) {
+        // demand paging admits a job of any size once its PCB page has a frame
+        return (canAdmitDemandJob() && !freeFrames.empty()) ? INT_MAX : 0;
+    }
+    if (pageSize > 0) {
+        return static_cast<int>(freeFrames.size()) << pageShift; // any free frames will do
+    }
+    return memoryAllocator->largestFreeBlock();
+}
+
+// - HELPER FUNCTION
+// loads a PCB from main memory
+// this reconstructs a PCB from its memory representation
+PCB loadPCBFromMemory(vector<int>& mainMemory, int address) {
+    PCB pcb;
+    
+    // the process table keeps the program counter, cpu cycles and parameter
+    // offset from the last save. they always match the PCB words: a STORE
+    // only reaches the storing process's own image, and every way off the
+    // CPU saves the PCB over whatever it stored there
+    pcb.tableRow = processTable.rowAt(address);
+    int row = pcb.tableRow;
+    bool cached = (row >= 0 && processTable.programCounter[row] != -1);
+    
+    // load the PCB fields from memory (the cached ones from the table)
+    pcb.processID = mainMemory[address];
+    pcb.state = static_cast<ProcessState>(mainMemory[address + 1]);
+    pcb.programCounter = cached ? processTable.programCounter[row] : mainMemory[address + 2];
+    pcb.instructionBase = mainMemory[address + 3];
+    pcb.dataBase = mainMemory[address + 4];
+    pcb.memoryLimit = mainMemory[address + 5];
+    pcb.cpuCyclesUsed = cached ? processTable.cpuCyclesUsed[row] : mainMemory[address + 6];
+    pcb.registerValue = mainMemory[address + 7];
+    pcb.maxMemoryNeeded = mainMemory[address + 8];
+    pcb.mainMemoryBase = mainMemory[address + 9];
+    
+    // the cached parameter offset also needs the executed opcodes (which the
+    // rescan reads) to be unchanged
+    if (cached && !processTable.opcodesRewritten[row]) {
+        pcb.paramOffset = processTable.paramOffset[row];
+    } else if (pcb.programCounter > 0) {
+        // calculate parameter offset based on executed instructions
+        pcb.paramOffset = 0;
+        
+        // go through all executed instructions and add up their parameter counts
+        for (int i = pcb.instructionBase; i < pcb.programCounter; i++) {
+            int opcode = readWord(mainMemory, row, i);
+            pcb.paramOffset += getParameterCount(static_cast<InstructionType>(opcode));
+        }
+    } else {
+        // process hasn't executed any instructions yet
+        pcb.paramOffset = 0;
+    }
+    
+    return pcb;
+}
+
+// - HELPER FUNCTION
+// saves a PCB to main memory
+// this stores a PCB in memory so it can be retrieved later
+void savePCBToMemory(vector<int>& mainMemory, int address, const PCB& pcb) {
+    // store all PCB fields in memory
+    mainMemory[address] = pcb.processID;
+    mainMemory[address + 1] = static_cast<int>(pcb.state);
+    mainMemory[address + 2] = pcb.programCounter;
+    mainMemory[address + 3] = pcb.instructionBase;
+    mainMemory[address + 4] = pcb.dataBase;
+    mainMemory[address + 5] = pcb.memoryLimit;
+    mainMemory[address + 6] = pcb.cpuCyclesUsed;
+    mainMemory[address + 7] = pcb.registerValue;
+    mainMemory[address + 8] = pcb.maxMemoryNeeded;
+    mainMemory[address + 9] = pcb.mainMemoryBase;
 
-// map to track when each process first entered the running state
-// used to calculate total execution time
-unordered_map<int, int> processStartTimes;
+    // keep the hot fields in the process table in step
+    if (pcb.tableRow >= 0) {
+        processTable.programCounter[pcb.tableRow] = pcb.programCounter;
+        processTable.paramOffset[pcb.tableRow] = pcb.paramOffset;
+        processTable.cpuCyclesUsed[pcb.tableRow] = pcb.cpuCyclesUsed;
+    }
+}
 
-// map to track memory blocks allocated to processes
-// allows quick access to a process's memory block by its ID
-unordered_map<int, list<MemoryBlock>::iterator> processMemoryBlocks;
+// - HELPER FUNCTION
+// produces the arrival time of the next job for the built-in generators
+// poisson: exponential gaps with mean arrivalGap
+// bursty: poisson arrivals during on periods, nothing during off periods
+// periodic: one job every arrivalGap time units
+int generateArrivalTime() {
+    if (arrivalMode == "periodic") {
+        double arrival = lastGeneratedArrival;
+        lastGeneratedArrival += arrivalGap;
+        return static_cast<int>(arrival);
+    }
 
-// global variables
-int globalClock = 0;           // tracks the current system time
-bool timeoutOccurred = false;  // indicates if a process timed out
-bool memoryFreed = false;      // indicates if memory was freed during execution
-int contextSwitchTime;         // time required to switch between processes
-int CPUAllocated;              // maximum CPU time a process can use before timeout
-queue<IOWaitItem> ioWaitingQueue; // queue of processes waiting for IO
+    exponential_distribution<double> gap(1.0 / arrivalGap);
+    double arrival = lastGeneratedArrival + gap(arrivalRandom);
+    if (arrivalMode == "bursty") {
+        // skip over any off period the arrival would fall into
+        int cycle = burstOnTime + burstOffTime;
+        double phase = arrival - cycle * static_cast<long long>(arrival / cycle);
+        if (phase >= burstOnTime) {
+            arrival += cycle - phase;
+        }
+    }
+    lastGeneratedArrival = arrival;
+    return static_cast<int>(arrival);
+}
 
 // - HELPER FUNCTION
-// converts a process state enum to a string for output
-// this makes the output more readable for humans
-string stateToString(ProcessState state) {
-    switch (state) {
-        case STATE_NEW: return "NEW";
-        case STATE_READY: return "READY";
-        case STATE_RUNNING: return "RUNNING";
-        case STATE_TERMINATED: return "TERMINATED";
-        case STATE_IOWAITING: return "IOWAITING";
-        default: return "UNKNOWN";
+// prints the arrival report at the end of the simulation
+void printArrivalReport() {
+    cout << "Arrival report (" << arrivalMode << "):" << endl;
+    cout << "Jobs arrived: " << arrivalStats.arrivals
+         << ". Last arrival at: " << arrivalStats.lastArrival << "." << endl;
+    if (arrivalStats.lastArrival > 0) {
+        cout << "Offered load: "
+             << (static_cast<double>(arrivalStats.totalCPUCycles) / arrivalStats.lastArrival)
+             << " cpu cycles per time unit." << endl;
+    }
+    if (admissionStats.admitted > 0) {
+        cout << "Average queueing delay (arrival to load): "
+             << (static_cast<double>(admissionStats.totalAdmissionWait) / admissionStats.admitted)
+             << "." << endl;
+    }
+    if (schedulingStats.terminated > 0) {
+        cout << "Average response time (arrival to first run): "
+             << (static_cast<double>(schedulingStats.totalResponse) / schedulingStats.terminated)
+             << "." << endl;
+        cout << "Average turnaround time (arrival to termination): "
+             << (static_cast<double>(schedulingStats.totalTurnaround) / schedulingStats.terminated)
+             << "." << endl;
     }
 }
 
 // - HELPER FUNCTION
-// gets the number of parameters for a specific instruction type
-// this is used when reading instructions and calculating parameter offsets
-int getParameterCount(InstructionType type) {
-    switch (type) {
-        case COMPUTE: return 2; // compute needs iterations and cycles
-        case PRINT: return 1;   // print only needs cycles
-        case STORE: return 2;   // store needs value and address
-        case LOAD: return 1;    // load only needs address
-        default: return 0;      // unknown instruction type has no parameters
+// reads one process record from the input
+// format: processID maxMemoryNeeded [deadline] [arrivalTime] numInstructions instructions...
+// the deadline is present with --deadlines, the arrival time with --arrivals=input
+int readProcess(PCB& process) {
+    int numInstructions;
+    int relativeDeadline = 0;
+    int arrivalTime = 0;
+
+    // read process ID, memory needed, and number of instructions
+    cin >> process.processID >> process.maxMemoryNeeded;
+    if (readDeadlines) {
+        cin >> relativeDeadline;
     }
-}
+    if (arrivalMode == "input") {
+        cin >> arrivalTime;
+    } else if (arrivalMode != "none") {
+        arrivalTime = generateArrivalTime();
+    }
+    cin >> numInstructions;
+    process.state = STATE_NEW;
+    process.memoryLimit = process.maxMemoryNeeded;
+    process.tableRow = processTable.addRow(process.processID);
+    largestProcessID = max(largestProcessID, process.processID);
 
-// allocates memory for a process
-// this finds a free memory block of sufficient size and assigns it to a process
-int allocateMemory(int processID, int size) {
-    // start at the beginning of the memory blocks list
-    list<MemoryBlock>::iterator current = memoryBlocks.begin();
-    list<MemoryBlock>::iterator prev = memoryBlocks.end();
-
-    // search through all memory blocks
-    while (current != memoryBlocks.end()) {
-        // check if this block is free and big enough
-        if (current->processID == -1 && current->size >= size) {
-            // found a suitable block, remember its starting address
-            int allocatedAddress = current->startAddress;
-
-            // if the block is exactly the right size, just mark it as allocated
-            if (current->size == size) {
-                current->processID = processID;
-                // store a reference to this block for quick access later
-                processMemoryBlocks[processID] = current;
-            }
-            else { 
-                // if the block is larger than needed, split it into two parts
-                // first part is allocated to the process, second part remains free
-                
-                // create a new block for the allocated portion
-                list<MemoryBlock>::iterator newBlock = memoryBlocks.insert(current, 
-                                                        MemoryBlock(processID, current->startAddress, size));
-                
-                // store a reference to this block for quick access later
-                processMemoryBlocks[processID] = newBlock;
+    // a deadline of 0 or less means the process has no deadline
+    if (relativeDeadline > 0) {
+        processTable.deadline[process.tableRow].relative = relativeDeadline;
+        processTable.deadline[process.tableRow].absolute = arrivalTime + relativeDeadline;
+    }
+    processTable.arrivalTime[process.tableRow] = max(0, arrivalTime);
+    arrivalStats.arrivals++;
+    arrivalStats.lastArrival = max(arrivalStats.lastArrival, arrivalTime);
 
-                // adjust the remaining free portion
-                current->startAddress += size;
-                current->size -= size;
-                
-                // return the starting address of the allocated block
-                return allocatedAddress;
-            }
+    // read and store all instructions for this process
+    for (int j = 0; j < numInstructions; j++) {
+        // read the instruction opcode
+        int rawOpcode;
+        cin >> rawOpcode;
+        // convert to instruction type
+        InstructionType operationType = static_cast<InstructionType>(rawOpcode);
+        
+        // create a new instruction
+        Instruction currentCmd(operationType);
+        // determine how many parameters this instruction requires
+        int requiredArgCount = getParameterCount(operationType);
 
-            // return the starting address of the allocated block
-            return allocatedAddress;
+        // read all parameters for this instruction
+        for (int argIndex = 0; argIndex < requiredArgCount; argIndex++) {
+            int argValue;
+            cin >> argValue;
+            currentCmd.parameters.push_back(argValue);
         }
 
-        // move to the next block
-        prev = current;
-        ++current;
+        // add this instruction to the process
+        process.instructions.push_back(currentCmd);
+    }
+
+    // segmented memory: the code segment words, laid out as placeJobInMemory writes them
+    if (segmentedMemory) {
+        vector<int>& code = processTable.codeImage[process.tableRow];
+        for (size_t i = 0; i < process.instructions.size(); i++) {
+            code.push_back(static_cast<int>(process.instructions[i].type));
+        }
+        for (size_t i = 0; i < process.instructions.size(); i++) {
+            const vector<int>& paramList = process.instructions[i].parameters;
+            code.insert(code.end(), paramList.begin(), paramList.end());
+        }
     }
 
-    // if we get here, no suitable block was found
-    return -1;
+    return arrivalTime;
 }
 
 // - HELPER FUNCTION
-// frees memory that was allocated to a process
-// this marks the memory as available for other processes
-void freeMemory(vector<int>& mainMemory, int processID) {
-    // check if this process has an allocated memory block
-    if (processMemoryBlocks.find(processID) == processMemoryBlocks.end()) {
-        return; // process doesn't have any allocated memory
+// reads process records from the input into the new job queue
+// normally everything is read up front; in streaming mode we stop as soon
+// as one job is waiting for its arrival time (jobs are expected in arrival
+// order) or, when every job arrives at 0, once the queue holds streamWindow
+// jobs, so host memory follows the jobs present in the system
+void readJobsFromInput(PendingJobQueue& newJobQueue) {
+    while (processesToRead > 0) {
+        if (streamingInput && !futureArrivals.empty()) {
+            return;
+        }
+        if (streamingInput && arrivalMode == "none" &&
+            static_cast<int>(newJobQueue.size()) >= streamWindow) {
+            return;
+        }
+
+        // create a new process control block
+        PCB process;
+        int arrivalTime = readProcess(process);
+        processesToRead--;
+
+        // add this process to the new job queue, or hold it until it arrives
+        if (arrivalTime <= 0) {
+            newJobQueue.push(process);
+        } else {
+            futureArrivals.insert(make_pair(arrivalTime, process));
+        }
+    }
+}
+
+// - HELPER FUNCTION
+// moves jobs whose arrival time has come into the new job queue
+// returns how many jobs arrived
+int releaseArrivedJobs(PendingJobQueue& newJobQueue) {
+    int released = 0;
+    while (!futureArrivals.empty() && futureArrivals.begin()->first <= globalClock) {
+        multimap<int, PCB>::iterator it = futureArrivals.begin();
+        cout << "Process " << it->second.processID << " arrived at time " << it->first << "." << endl;
+        newJobQueue.push(it->second);
+        futureArrivals.erase(it);
+        released++;
+
+        // in streaming mode the next record is only read now
+        readJobsFromInput(newJobQueue);
     }
+    return released;
+}
+
+// - HELPER FUNCTION
+// copies a job into the memory block it was given and makes it ready
+// this writes the PCB, then all opcodes, then all parameters
+void placeJobInMemory(PCB& currentJob, int assignedLocation, int requiredSpace,
+                      queue<int>& executionQueue, vector<int>& systemMemory) {
+    // set up memory layout for this job (with paging or segments the image starts at virtual 0)
+    currentJob.mainMemoryBase = (pageSize > 0 || segmentedMemory) ? 0 : assignedLocation;
+    currentJob.instructionBase = currentJob.mainMemoryBase + 10;  // PCB takes 10 slots
     
-    // get the memory block for this process
-    list<MemoryBlock>::iterator blockIt = processMemoryBlocks[processID];
-    int startAddress = blockIt->startAddress;
-    int size = blockIt->size;
+    // calculate where data starts (after all instructions)
+    int instructionCount = currentJob.instructions.size();
+    currentJob.dataBase = currentJob.instructionBase + instructionCount;
+    
+    // save the PCB to memory
+    savePCBToMemory(systemMemory, assignedLocation, currentJob);
+    
+    stampWords(assignedLocation, 10);
+    
+    // a shared code segment already holds the opcodes and parameters
+    int row = currentJob.tableRow;
+    const Segment& code = processTable.segments[row].code;
+    bool codeShared = segmentedMemory && code.limit > 0 && codeSegments[code.base].refs > 1;
+    vector<int>().swap(processTable.codeImage[row]);
+    
+    // first store all instruction opcodes
+    int memoryIndex = currentJob.instructionBase;
+    vector<int> image; // with demand paging the program is collected here first
+    for (size_t i = 0; !codeShared && i < currentJob.instructions.size(); i++) {
+        if (pageReplacer != NULL) {
+            image.push_back(static_cast<int>(currentJob.instructions[i].type));
+        } else {
+            writeWord(systemMemory, row, memoryIndex++, static_cast<int>(currentJob.instructions[i].type));
+        }
+    }
+    
+    // then store all instruction parameters
+    for (size_t i = 0; !codeShared && i < currentJob.instructions.size(); i++) {
+        const vector<int>& paramList = currentJob.instructions[i].parameters;
+        for (size_t j = 0; j < paramList.size(); j++) {
+            if (pageReplacer != NULL) {
+                image.push_back(paramList[j]);
+            } else {
+                writeWord(systemMemory, row, memoryIndex++, paramList[j]);
+            }
+        }
+    }
+    if (pageReplacer != NULL) {
+        storeImageOnDemand(systemMemory, row, currentJob.instructionBase, image);
+    }
     
-    // clear memory by setting all values to -1
-    for (int i = startAddress; i < startAddress + size; i++) {
-        mainMemory[i] = -1;
+    // print a message that job was loaded
+    if (pageSize > 0) {
+        cout << "Process " << currentJob.processID << " loaded into " << processTable.pageTable[row].size()
+             << " pages with size " << requiredSpace << ". PCB at address " << assignedLocation << "." << endl;
+    } else if (segmentedMemory) {
+        cout << "Process " << currentJob.processID << " loaded with data segment at " << assignedLocation
+             << " (" << processTable.segments[row].data.limit << " words) and " << (codeShared ? "shared " : "")
+             << "code segment at " << code.base << " (" << code.limit << " words)." << endl;
+    } else {
+        cout << "Process " << currentJob.processID << " loaded into memory at address "
+             << assignedLocation << " with size " << requiredSpace << "." << endl;
     }
     
-    // mark the block as free
-    blockIt->processID = -1;
+    // flag loads that the original first fit allocator would have placed elsewhere
+    if (placementCheck && lastFirstFitAddress != -1 && lastFirstFitAddress != assignedLocation) {
+        cout << "Placement differs from first fit for Process " << currentJob.processID
+             << " (first fit address " << lastFirstFitAddress << ")." << endl;
+        placementDifferences++;
+    }
     
-    // remove the reference to this block from the map
-    processMemoryBlocks.erase(processID);
+    // add to execution queue (ready queue)
+    executionQueue.push(assignedLocation);
+    admissionStats.admitted++;
+    admissionStats.totalAdmissionWait += globalClock - getArrivalTime(currentJob.tableRow);
 }
 
-// merges adjacent free memory blocks to create larger free blocks
-// this helps reduce memory fragmentation
-void coalesceMemory() {
-    // start at the beginning of the memory blocks list
-    list<MemoryBlock>::iterator current = memoryBlocks.begin();
+// - HELPER FUNCTION
+// moves a process's PCB fields to a new location in memory
+// the image has already been copied to newAddress; every address the PCB
+// holds is shifted by the same amount so the process runs as before
+void relocatePCB(vector<int>& mainMemory, int newAddress) {
+    PCB pcb = loadPCBFromMemory(mainMemory, newAddress);
+    int delta = newAddress - pcb.mainMemoryBase;
+    pcb.mainMemoryBase += delta;
+    pcb.instructionBase += delta;
+    pcb.dataBase += delta;
+    if (pcb.programCounter > 0) {
+        pcb.programCounter += delta; // an absolute address once the process has run
+    }
+    savePCBToMemory(mainMemory, newAddress, pcb);
+}
+
+// - HELPER FUNCTION
+// FORK with paging: gives a child a page table sharing the parent's frames
+// only page 0 is copied, since the child's PCB goes there
+// returns the physical address of the child's page 0, or -1
+int forkPages(vector<int>& mainMemory, int parentRow, int childRow) {
+    if (freeFrames.empty()) {
+        return -1;
+    }
+    const vector<int>& parentTable = processTable.pageTable[parentRow];
+    vector<int>& table = processTable.pageTable[childRow];
+    table = parentTable;
+    int frame = freeFrames.back();
+    freeFrames.pop_back();
+    materializeWords(mainMemory, parentTable[0] << pageShift, pageSize);
+    copy(mainMemory.begin() + (parentTable[0] << pageShift),
+         mainMemory.begin() + (parentTable[0] << pageShift) + pageSize,
+         mainMemory.begin() + (frame << pageShift));
+    stampWords(frame << pageShift, pageSize);
+    table[0] = frame;
+    frameRefs[frame] = 1;
+    for (size_t page = 1; page < table.size(); page++) {
+        frameRefs[table[page]]++;
+    }
+    forkStats.pagesShared += table.size() - 1;
+    forkStats.wordsCopied += pageSize;
 
-    // scan through the list looking for adjacent free blocks
-    while (current != memoryBlocks.end() && current != --memoryBlocks.end()) {
-        // get the next block
-        list<MemoryBlock>::iterator next = current;
-        ++next;
+    int size = processTable.block[parentRow].size;
+    int pages = table.size();
+    pagingStats.framesInUse++;
+    pagingStats.peakFramesInUse = max(pagingStats.peakFramesInUse, pagingStats.framesInUse);
+    pagingStats.pageTableEntries += pages;
+    pagingStats.peakPageTableEntries = max(pagingStats.peakPageTableEntries, pagingStats.pageTableEntries);
+    pagingStats.unusedWords += (pages << pageShift) - size;
+    pagingStats.peakUnusedWords = max(pagingStats.peakUnusedWords, pagingStats.unusedWords);
 
-        // check if we've reached the end of the list
-        if (next == memoryBlocks.end()) {
-            break;
+    int pcbAddress = frame << pageShift;
+    processTable.block[childRow] = MemoryBlock(processTable.processID[childRow], pcbAddress, size);
+    processTable.rowAtAddress[pcbAddress] = childRow;
+    updateMemoryUsage(pageSize);
+    traceEvent(processTable.processID[childRow], size);
+    return pcbAddress;
+}
+
+// - HELPER FUNCTION
+// FORK with demand paging: gives a child its own page 0 and its own page
+// file slots. page 0 is copied into a new frame; every other page the
+// parent has contents for (in a frame or in the page file) is written to a
+// new slot, to be read in when the child touches it
+// returns the physical address of the child's page 0, or -1
+int forkDemandPages(vector<int>& mainMemory, int parentRow, int childRow) {
+    const vector<int>& parentTable = processTable.pageTable[parentRow];
+    int pages = parentTable.size();
+    int pcbAddress = allocateDemandPages(childRow, processTable.block[parentRow].size, pages);
+    if (pcbAddress == -1) {
+        return -1;
+    }
+    materializeWords(mainMemory, parentTable[0] << pageShift, pageSize);
+    copy(mainMemory.begin() + (parentTable[0] << pageShift),
+         mainMemory.begin() + (parentTable[0] << pageShift) + pageSize,
+         mainMemory.begin() + pcbAddress);
+    stampWords(pcbAddress, pageSize);
+    forkStats.wordsCopied += pageSize;
+
+    vector<int> buffer(pageSize);
+    for (int page = 1; page < pages; page++) {
+        int frame = parentTable[page];
+        int slot = processTable.pageSlot[parentRow][page];
+        const int* words;
+        if (frame != -1) {
+            materializeWords(mainMemory, frame << pageShift, pageSize);
+            words = &mainMemory[frame << pageShift];
+        } else if (slot != -1) {
+            pageFile.seekg(static_cast<long long>(slot) * pageSize * sizeof(int));
+            pageFile.read(reinterpret_cast<char*>(&buffer[0]), pageSize * sizeof(int));
+            words = &buffer[0];
+        } else {
+            continue; // never written, so the child's copy is zero filled too
+        }
+        int childSlot = allocatePageSlot();
+        writePageSlot(childSlot, words);
+        processTable.pageSlot[childRow][page] = childSlot;
+        forkStats.pagesToFile++;
+    }
+    return pcbAddress;
+}
+
+// - HELPER FUNCTION
+// FORK with segments: gives a child a block of its own for its PCB and a
+// share of the parent's data and code segments
+// returns the address of the child's PCB, or -1
+int forkSegments(int parentRow, int childRow) {
+    const SegmentTable& parentSegments = processTable.segments[parentRow];
+    int childID = processTable.processID[childRow];
+    int pcbBase = memoryAllocator->allocate(childID, 10);
+    if (pcbBase == -1) {
+        return -1;
+    }
+    stampWords(pcbBase, 10);
+    DataSegment& pcb = dataSegments[pcbBase];
+    pcb.refs = 0;
+    pcb.holdsPCB = true;
+    pcb.limit = 10;
+    updateMemoryUsage(10);
+    trackFragmentation(pcbBase, 10);
+
+    SegmentTable& segments = processTable.segments[childRow];
+    segments = parentSegments;
+    dataSegments[segments.data.base].refs++;
+    forkStats.dataShared++;
+    if (segments.code.limit > 0) {
+        codeSegments[segments.code.base].refs++;
+        changeSharedWords(segments.code.limit);
+    }
+    processTable.block[childRow] = MemoryBlock(childID, pcbBase, processTable.block[parentRow].size);
+    processTable.rowAtAddress[pcbBase] = childRow;
+    return pcbBase;
+}
+
+// - HELPER FUNCTION
+// FORK: creates a child that continues after the FORK with its own PCB
+// with paging the child shares the parent's pages copy-on-write, with
+// segments its data and code segments. with demand paging a frame cannot
+// be in several page tables, so the child's pages go to page file slots of
+// its own. a contiguous block cannot be shared in part, so there the image
+// is copied
+// returns the child's process ID, or -1 if there was no memory for it
+int forkProcess(vector<int>& mainMemory, const PCB& parent, queue<int>& readyQueue) {
+    int parentRow = parent.tableRow;
+    int size = processTable.block[parentRow].size;
+    int parentAddress = processTable.block[parentRow].startAddress;
+    int childID = largestProcessID + 1; // cannot be the PID of a process read so far
+    int childRow = processTable.addRow(childID);
+
+    int childAddress;
+    if (pageReplacer != NULL) {
+        childAddress = forkDemandPages(mainMemory, parentRow, childRow);
+    } else if (pageSize > 0) {
+        childAddress = forkPages(mainMemory, parentRow, childRow);
+    } else if (segmentedMemory) {
+        childAddress = forkSegments(parentRow, childRow);
+    } else {
+        childAddress = allocateMemory(childRow, size);
+        if (childAddress != -1) {
+            materializeWords(mainMemory, parentAddress, size);
+            copy(mainMemory.begin() + parentAddress, mainMemory.begin() + parentAddress + size,
+                 mainMemory.begin() + childAddress);
+            stampWords(childAddress, size);
+            forkStats.wordsCopied += size;
+        }
+    }
+    if (childAddress == -1) {
+        processTable.releaseRow(childRow);
+        forkStats.failures++;
+        return -1;
+    }
+
+    // the child starts at the instruction after the FORK, with 0 in its register
+    PCB child = parent;
+    child.processID = childID;
+    child.tableRow = childRow;
+    child.state = STATE_READY;
+    child.programCounter = parent.programCounter + 1;
+    child.cpuCyclesUsed = 0;
+    child.registerValue = 0;
+    processTable.arrivalTime[childRow] = globalClock;
+    processTable.startTime[childRow] = globalClock;
+    processTable.opcodesRewritten[childRow] = processTable.opcodesRewritten[parentRow];
+    savePCBToMemory(mainMemory, childAddress, child);
+    if (pageSize == 0 && !segmentedMemory) {
+        relocatePCB(mainMemory, childAddress); // its addresses still point into the parent
+    }
+
+    forkStats.forks++;
+    largestProcessID = childID;
+    readyQueue.push(childAddress);
+    return childID;
+}
+
+// - HELPER FUNCTION
+// segmented memory: gives a process its own copy of its code segment
+// before it STOREs into it while other processes share it. a code segment
+// nobody else uses is just taken out of the hash index, since it changes
+// returns false if there was no room for the copy
+bool copyCodeOnWrite(vector<int>& mainMemory, int row, int address) {
+    Segment& code = processTable.segments[row].code;
+    if (address < 10 || address - 10 >= code.limit) {
+        return true; // a data segment word
+    }
+    CodeSegment& segment = codeSegments[code.base];
+    if (segment.refs == 1) {
+        unlistCodeSegment(code.base);
+        return true;
+    }
+    int copyBase = memoryAllocator->allocate(processTable.processID[row], code.limit);
+    if (copyBase == -1) {
+        segmentStats.copyFailures++;
+        return false;
+    }
+    materializeWords(mainMemory, code.base, code.limit);
+    copy(mainMemory.begin() + code.base, mainMemory.begin() + code.base + code.limit,
+         mainMemory.begin() + copyBase);
+    stampWords(copyBase, code.limit);
+    segment.refs--;
+    changeSharedWords(-code.limit);
+    CodeSegment& copied = codeSegments[copyBase];
+    copied.refs = 1;
+    copied.hash = 0;
+    copied.listed = false;
+    code.base = copyBase;
+    updateMemoryUsage(code.limit);
+    trackFragmentation(copyBase, code.limit);
+    segmentStats.liveSegments++;
+    segmentStats.peakLiveSegments = max(segmentStats.peakLiveSegments, segmentStats.liveSegments);
+    segmentStats.codeCopies++;
+    return true;
+}
+
+// - HELPER FUNCTION
+// segmented memory: gives a process its own copy of its data segment
+// before it STOREs into it while a forked relative still shares it. the
+// PCB stays where it is, so the old block may still hold it
+// returns false if there was no room for the copy
+bool copyDataOnWrite(vector<int>& mainMemory, int row, int address) {
+    const SegmentTable& segments = processTable.segments[row];
+    if (address < 10 + segments.code.limit) {
+        return true; // the PCB (always private) or a code segment word
+    }
+    Segment& data = processTable.segments[row].data;
+    DataSegment& segment = dataSegments[data.base];
+    if (segment.refs == 1) {
+        return true;
+    }
+    int copyBase = memoryAllocator->allocate(processTable.processID[row], data.limit);
+    if (copyBase == -1) {
+        forkStats.copyFailures++;
+        return false;
+    }
+    materializeWords(mainMemory, data.base, data.limit);
+    copy(mainMemory.begin() + data.base, mainMemory.begin() + data.base + data.limit,
+         mainMemory.begin() + copyBase);
+    stampWords(copyBase, data.limit);
+    segment.refs--;
+    DataSegment& copied = dataSegments[copyBase];
+    copied.refs = 1;
+    copied.holdsPCB = false;
+    copied.limit = data.limit;
+    data.base = copyBase;
+    updateMemoryUsage(data.limit);
+    trackFragmentation(copyBase, data.limit);
+    forkStats.dataCopies++;
+    return true;
+}
+
+// - HELPER FUNCTION
+// copy-on-write: gives a process its own copy of a page it is about to
+// STORE to while a forked relative still shares it
+// returns false if no frame was free for the copy
+bool copyOnWrite(vector<int>& mainMemory, int row, int address) {
+    if (segmentedMemory) {
+        return copyCodeOnWrite(mainMemory, row, address) && copyDataOnWrite(mainMemory, row, address);
+    }
+    if (pageSize == 0 || forkStats.pagesShared == 0) {
+        return true; // nothing was ever shared
+    }
+    vector<int>& table = processTable.pageTable[row];
+    int page = address >> pageShift;
+    int frame = table[page];
+    if (frameRefs[frame] <= 1) {
+        return true;
+    }
+    if (freeFrames.empty()) {
+        forkStats.copyFailures++;
+        return false;
+    }
+    int copyFrame = freeFrames.back();
+    freeFrames.pop_back();
+    materializeWords(mainMemory, frame << pageShift, pageSize);
+    copy(mainMemory.begin() + (frame << pageShift), mainMemory.begin() + (frame << pageShift) + pageSize,
+         mainMemory.begin() + (copyFrame << pageShift));
+    stampWords(copyFrame << pageShift, pageSize);
+    frameRefs[frame]--;
+    frameRefs[copyFrame] = 1;
+    table[page] = copyFrame;
+    if (tlbEntries > 0) {
+        tlb.invalidate(processTable.processID[row], page);
+    }
+    pagingStats.framesInUse++;
+    pagingStats.peakFramesInUse = max(pagingStats.peakFramesInUse, pagingStats.framesInUse);
+    updateMemoryUsage(pageSize);
+    forkStats.pageCopies++;
+    return true;
+}
+
+// - HELPER FUNCTION
+// reserves room for an image in the swap file, reusing old extents first
+long long allocateSwapSpace(int size) {
+    for (size_t i = 0; i < swapFileHoles.size(); i++) {
+        if (swapFileHoles[i].second >= size) {
+            long long offset = swapFileHoles[i].first;
+            swapFileHoles[i].first += size;
+            swapFileHoles[i].second -= size;
+            if (swapFileHoles[i].second == 0) {
+                swapFileHoles.erase(swapFileHoles.begin() + i);
+            }
+            return offset;
+        }
+    }
+    long long offset = swapFileEnd;
+    swapFileEnd += size;
+    return offset;
+}
+
+// - HELPER FUNCTION
+// writes a process image to the backing store and frees its memory block
+void swapOutProcess(vector<int>& mainMemory, IOWaitItem& item) {
+    const MemoryBlock& block = processTable.block[item.tableRow];
+    SwapRecord record;
+    record.size = block.size;
+    record.oldAddress = block.startAddress;
+    record.fileOffset = allocateSwapSpace(record.size);
+
+    // copy the image out word for word
+    materializeWords(mainMemory, record.oldAddress, record.size);
+    swapFile.seekp(record.fileOffset * sizeof(int));
+    swapFile.write(reinterpret_cast<const char*>(&mainMemory[record.oldAddress]),
+                   record.size * sizeof(int));
+
+    freeMemory(mainMemory, item.tableRow);
+    processTable.swapRecord[item.tableRow] = record;
+    item.pcbAddress = -1;
+    swapStats.swapOuts++;
+    swapStats.wordsOut += record.size;
+
+    cout << "Process " << item.processID << " swapped out to backing store ("
+         << record.size << " words)." << endl;
+}
+
+// - HELPER FUNCTION
+// tries to bring a swapped out process back into memory
+// returns the new PCB address, or -1 if there is no room yet
+int swapInProcess(vector<int>& mainMemory, int row) {
+    const SwapRecord& record = processTable.swapRecord[row];
+    int newAddress = allocateMemory(row, record.size);
+    if (newAddress == -1 && !memoryAllocator->coalescesOnRelease()) {
+        coalesceMemory();
+        newAddress = allocateMemory(row, record.size);
+    }
+    if (newAddress == -1) {
+        return -1;
+    }
+
+    // copy the image back and fix up its addresses
+    swapFile.seekg(record.fileOffset * sizeof(int));
+    swapFile.read(reinterpret_cast<char*>(&mainMemory[newAddress]), record.size * sizeof(int));
+    stampWords(newAddress, record.size);
+    relocatePCB(mainMemory, newAddress);
+
+    swapFileHoles.push_back(make_pair(record.fileOffset, record.size));
+    swapStats.swapIns++;
+    swapStats.wordsIn += record.size;
+
+    cout << "Process " << processTable.processID[row] << " swapped in at address " << newAddress << "." << endl;
+    return newAddress;
+}
+
+// - HELPER FUNCTION
+// medium-term scheduler: swaps out processes that have been waiting for IO
+// for at least swapAfter time units until a job of 'requiredSpace' fits
+// the candidates are taken in queue order on a map of the images in memory
+// first, until one of them leaves a hole the job fits in. only the
+// candidates inside that hole are swapped out, and none if there is no such
+// hole, so no image goes out without making room for the job
+// returns true if it freed anything
+bool swapOutWaitingProcesses(vector<int>& mainMemory, int requiredSpace) {
+    // only bother if swapping out every candidate could make enough room
+    vector<int> candidates; // table rows, in queue order
+    int reclaimable = 0;
+    int waitingCount = ioWaitingQueue.size();
+    for (int i = 0; i < waitingCount; i++) {
+        IOWaitItem item = ioWaitingQueue.front();
+        ioWaitingQueue.pop();
+        bool stillBusy = (globalClock - item.entryTime < item.waitDuration);
+        if (item.pcbAddress != -1 && stillBusy && globalClock - item.entryTime >= swapAfter) {
+            candidates.push_back(item.tableRow);
+            reclaimable += processTable.block[item.tableRow].size;
+        }
+        ioWaitingQueue.push(item);
+    }
+    if (reclaimable == 0) {
+        return false;
+    }
+    if (memoryAllocator->freeWords() + reclaimable < requiredSpace) {
+        return false;
+    }
+
+    // start -> end of every image in memory (as the allocator holds it)
+    map<int, int> used;
+    for (size_t row = 0; row < processTable.block.size(); row++) {
+        const MemoryBlock& block = processTable.block[row];
+        if (block.processID != -1) {
+            used[block.startAddress] = block.startAddress + memoryAllocator->roundedSize(block.size);
+        }
+    }
+
+    // take the candidates out one by one and look at the hole each one leaves
+    int holeStart = -1;
+    int holeEnd = -1;
+    for (size_t i = 0; i < candidates.size() && holeStart == -1; i++) {
+        map<int, int>::iterator next = used.find(processTable.block[candidates[i]].startAddress);
+        used.erase(next++);
+        int end = (next == used.end()) ? static_cast<int>(mainMemory.size()) : next->first;
+        int start = 0;
+        if (next != used.begin()) {
+            map<int, int>::iterator before = next;
+            --before;
+            start = before->second;
+        }
+        if (memoryAllocator->fitsInRange(start, end, requiredSpace)) {
+            holeStart = start;
+            holeEnd = end;
+        }
+    }
+    if (holeStart == -1) {
+        return false;
+    }
+
+    // swap out the candidates in that hole
+    bool freedAny = false;
+    for (int i = 0; i < waitingCount; i++) {
+        IOWaitItem item = ioWaitingQueue.front();
+        ioWaitingQueue.pop();
+        bool stillBusy = (globalClock - item.entryTime < item.waitDuration);
+        if (item.pcbAddress != -1 && stillBusy && globalClock - item.entryTime >= swapAfter &&
+            item.pcbAddress >= holeStart && item.pcbAddress < holeEnd) {
+            swapOutProcess(mainMemory, item);
+            freedAny = true;
+        }
+        ioWaitingQueue.push(item);
+    }
+    if (freedAny) {
+        coalesceMemory();
+    }
+    return freedAny;
+}
+
+// - HELPER FUNCTION
+// prints the paging report at the end of the simulation
+// a page table entry is counted as one word of memory
+void printPagingReport(int maxMemory) {
+    int frames = maxMemory >> pageShift;
+    cout << "Paging report (" << pageSize << " word pages):" << endl;
+    cout << "Frames: " << frames << ". Peak frames in use: " << pagingStats.peakFramesInUse << "." << endl;
+    cout << "Peak page table size: " << pagingStats.peakPageTableEntries << " entries ("
+         << (100.0 * pagingStats.peakPageTableEntries / maxMemory) << "% of memory)." << endl;
+    cout << "Peak unused words in last pages: " << pagingStats.peakUnusedWords << "." << endl;
+    cout << "Address translations: " << pagingStats.translations << " ("
+         << (pagingStats.instructions > 0 ? static_cast<double>(pagingStats.translations) / pagingStats.instructions : 0.0)
+         << " per instruction)." << endl;
+}
+
+// - HELPER FUNCTION
+// prints the TLB report at the end of the simulation
+void printTLBReport() {
+    cout << "TLB report (" << tlb.entries.size() << " entries, " << tlbWays << " way" << (tlbWays == 1 ? "" : "s")
+         << ", " << tlbPolicy << ", " << (tlbASIDs ? "ASIDs" : "flush on switch") << "):" << endl;
+    const char* kindNames[3] = { "", "Fetch", "LOAD/STORE" };
+    long long hits = 0;
+    long long misses = 0;
+    for (int kind = FETCH_ACCESS; kind <= DATA_ACCESS; kind++) {
+        long long lookups = tlb.hits[kind] + tlb.misses[kind];
+        cout << kindNames[kind] << " lookups: " << lookups << ". Hits: " << tlb.hits[kind]
+             << ". Hit rate: " << (lookups > 0 ? 100.0 * tlb.hits[kind] / lookups : 0.0) << "%." << endl;
+        hits += tlb.hits[kind];
+        misses += tlb.misses[kind];
+    }
+    cout << "Overall hit rate: " << (hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0)
+         << "%. Flushes: " << tlb.flushes << ". Time charged for misses: " << tlb.missCycles << "." << endl;
+    cout << "Hit rate by process (in termination order):" << endl;
+    for (size_t i = 0; i < tlbProcessCounts.size(); i++) {
+        const TLBProcessCounts& counts = tlbProcessCounts[i];
+        long long lookups = counts.hits + counts.misses;
+        cout << "Process " << counts.processID << ": " << counts.hits << " hits, " << counts.misses
+             << " misses, " << (lookups > 0 ? 100.0 * counts.hits / lookups : 0.0) << "%." << endl;
+    }
+}
+
+// - HELPER FUNCTION
+// prints the demand paging report at the end of the simulation
+void printDemandPagingReport() {
+    cout << "Demand paging report (" << pageReplacer->name() << ", fault time " << pageFaultTime << "):" << endl;
+    cout << "Page faults: " << demandStats.faults << " ("
+         << (pagingStats.instructions > 0 ? 1000.0 * demandStats.faults / pagingStats.instructions : 0.0)
+         << " per 1000 instructions, "
+         << (demandStats.references > 0 ? 100.0 * demandStats.faults / demandStats.references : 0.0)
+         << "% of " << demandStats.references << " page references)." << endl;
+    cout << "Pages read: " << demandStats.pagesIn << ". Zero filled: " << demandStats.zeroFills
+         << ". Pages written: " << demandStats.pagesOut << ". Clean evictions: " << demandStats.cleanDrops
+         << "." << endl;
+    cout << "Page file: " << demandStats.imagePages << " image pages written at load, "
+         << pageSlotsUsed << " slots (" << (static_cast<long long>(pageSlotsUsed) * pageSize)
+         << " words)." << endl;
+    cout << "Throughput: " << (globalClock > 0 ? 1000.0 * schedulingStats.terminated / globalClock : 0.0)
+         << " processes per 1000 time units. Peak working set total: " << demandStats.peakWorkingSet
+         << " pages (window " << workingSetWindow << ") for " << frameRow.size() << " frames." << endl;
+    if (loadControl) {
+        cout << "Load control: " << demandStats.suspensions << " suspensions, " << demandStats.resumes
+             << " resumes." << endl;
+    }
+}
+
+// - HELPER FUNCTION
+// prints the segment report at the end of the simulation
+void printSegmentReport(int maxMemory) {
+    cout << "Segment report:" << endl;
+    cout << "Jobs loaded: " << segmentStats.loads << ". With a shared code segment: " << segmentStats.sharedLoads
+         << " (" << (segmentStats.loads > 0 ? 100.0 * segmentStats.sharedLoads / segmentStats.loads : 0.0)
+         << "%). Code words not loaded: " << segmentStats.wordsNotLoaded << "." << endl;
+    cout << "Peak memory saved by sharing: " << segmentStats.peakWordsSaved << " words ("
+         << (100.0 * segmentStats.peakWordsSaved / maxMemory) << "% of memory). Peak code segments: "
+         << segmentStats.peakLiveSegments << "." << endl;
+    cout << "Jobs admitted only because their code was shared: " << segmentStats.sharedAdmissions << "." << endl;
+    cout << "Shared code segments copied on STORE: " << segmentStats.codeCopies
+         << ". Copies with no free memory: " << segmentStats.copyFailures << "." << endl;
+}
+
+// - HELPER FUNCTION
+// prints the fork report at the end of the simulation
+void printForkReport() {
+    cout << "Fork report:" << endl;
+    cout << "Forks: " << forkStats.forks << ". Failed: " << forkStats.failures
+         << ". Words copied at fork time: " << forkStats.wordsCopied << "." << endl;
+    if (pageReplacer != NULL) {
+        cout << "Child pages written to the page file at fork: " << forkStats.pagesToFile << "." << endl;
+    } else if (pageSize > 0) {
+        cout << "Pages shared at fork: " << forkStats.pagesShared << ". Copied on STORE: " << forkStats.pageCopies
+             << " (" << (forkStats.pagesShared > 0 ? 100.0 * forkStats.pageCopies / forkStats.pagesShared : 0.0)
+             << "%). Copies with no free frame: " << forkStats.copyFailures << "." << endl;
+    } else if (segmentedMemory) {
+        cout << "Data segments shared at fork: " << forkStats.dataShared << ". Copied on STORE: "
+             << forkStats.dataCopies << " ("
+             << (forkStats.dataShared > 0 ? 100.0 * forkStats.dataCopies / forkStats.dataShared : 0.0) << "%). Copies with no free memory: " << forkStats.copyFailures << "." << endl;
+    }
+}
+
+// - HELPER FUNCTION
+// prints the swap report at the end of the simulation
+void printSwapReport() {
+    cout << "Swap report:" << endl;
+    cout << "Swap outs: " << swapStats.swapOuts << " (" << swapStats.wordsOut << " words). "
+         << "Swap ins: " << swapStats.swapIns << " (" << swapStats.wordsIn << " words)." << endl;
+    cout << "Swap in stalls: " << swapStats.swapInStalls << "." << endl;
+}
+
+// - HELPER FUNCTION
+// points the PCB addresses held by the ready queue and the IO waiting
+// queue at the new places of moved process images
+void retargetPCBAddresses(queue<int>& readyQueue, const unordered_map<int, int>& newAddressOf) {
+    int readyCount = readyQueue.size();
+    for (int i = 0; i < readyCount; i++) {
+        int address = readyQueue.front();
+        readyQueue.pop();
+        unordered_map<int, int>::const_iterator moved = newAddressOf.find(address);
+        readyQueue.push(moved == newAddressOf.end() ? address : moved->second);
+    }
+    int waitingCount = ioWaitingQueue.size();
+    for (int i = 0; i < waitingCount; i++) {
+        IOWaitItem item = ioWaitingQueue.front();
+        ioWaitingQueue.pop();
+        unordered_map<int, int>::const_iterator moved = newAddressOf.find(item.pcbAddress);
+        if (moved != newAddressOf.end()) {
+            item.pcbAddress = moved->second;
         }
+        ioWaitingQueue.push(item);
+    }
+}
+
+// - HELPER FUNCTION
+// the rows of all processes that have memory, keyed by block address
+map<int, int> liveBlocksByAddress() {
+    map<int, int> liveBlocks;
+    for (size_t row = 0; row < processTable.block.size(); row++) {
+        if (processTable.block[row].processID != -1) {
+            liveBlocks[processTable.block[row].startAddress] = row;
+        }
+    }
+    return liveBlocks;
+}
+
+// - HELPER FUNCTION
+// compaction: slides every process image down to the lowest free address so
+// all free memory ends up as one block at the top
+// each image is copied inside mainMemory and its PCB is rebased with
+// relocatePCB; the ready queue and the IO waiting queue hold PCB addresses,
+// so those are rewritten too. returns true if anything moved
+bool compactMemory(vector<int>& mainMemory, queue<int>& readyQueue) {
+    // blocks have to be placed at exact addresses (the buddy allocator cannot)
+    if (!memoryAllocator->canRelocate()) {
+        return false;
+    }
+
+    // slide each block down to the end of the ones before it
+    map<int, int> liveBlocks = liveBlocksByAddress();
+    unordered_map<int, int> newAddressOf; // old PCB address -> new PCB address
+    vector<MemoryBlock> packed;           // every block where it ends up
+    vector<MemoryBlock> moved;            // the blocks that moved, where they were
+    long long wordsMoved = 0;
+    int target = 0;
+    for (map<int, int>::iterator it = liveBlocks.begin(); it != liveBlocks.end(); ++it) {
+        MemoryBlock block = processTable.block[it->second];
+        packed.push_back(MemoryBlock(block.processID, target, block.size));
+        if (block.startAddress != target) {
+            moved.push_back(block);
+
+            // copy the image down and scrub the words it no longer covers
+            materializeWords(mainMemory, block.startAddress, block.size);
+            copy(mainMemory.begin() + block.startAddress, mainMemory.begin() + block.startAddress + block.size,
+                 mainMemory.begin() + target);
+            stampWords(target, block.size);
+            int vacated = max(block.startAddress, target + block.size);
+            scrubFreedWords(mainMemory, vacated, block.startAddress + block.size - vacated);
+            processTable.moveBlock(it->second, target);
+            trackFragmentation(block.startAddress, -block.size);
+            trackFragmentation(target, block.size);
+            relocatePCB(mainMemory, target);
+
+            newAddressOf[block.startAddress] = target;
+            wordsMoved += block.size;
+        }
+        target += block.size;
+    }
+    if (newAddressOf.empty()) {
+        return false; // memory was already compact
+    }
+
+    // tell the allocator, in one pass if it can, otherwise block by block
+    // (allocateAt cannot fail: everything below a block is free by then)
+    if (!memoryAllocator->rebuildCompacted(packed)) {
+        for (size_t i = 0; i < moved.size(); i++) {
+            memoryAllocator->release(moved[i].startAddress);
+            memoryAllocator->allocateAt(moved[i].processID, newAddressOf[moved[i].startAddress], moved[i].size);
+        }
+    }
+    coalesceMemory(); // nothing left to merge, but the trace records it
+
+    retargetPCBAddresses(readyQueue, newAddressOf);
+
+    compactionStats.compactions++;
+    compactionStats.processesMoved += newAddressOf.size();
+    compactionStats.wordsMoved += wordsMoved;
+    cout << "Memory compacted. " << newAddressOf.size() << " processes moved ("
+         << wordsMoved << " words)." << endl;
+    return true;
+}
+
+// - HELPER FUNCTION
+// picks the next image for the idle compactor: the lowest one with a hole
+// below it. the allocator is updated right away, which is safe because the
+// move is finished before anything else allocates memory
+// returns false if memory is already compact
+bool startIdleMove() {
+    map<int, int> liveBlocks = liveBlocksByAddress();
+    int target = 0;
+    for (map<int, int>::iterator it = liveBlocks.begin(); it != liveBlocks.end(); ++it) {
+        const MemoryBlock& block = processTable.block[it->second];
+        if (block.startAddress != target) {
+            memoryAllocator->release(block.startAddress);
+            if (!memoryAllocator->allocateAt(block.processID, target, block.size)) {
+                memoryAllocator->allocateAt(block.processID, block.startAddress, block.size);
+                return false;
+            }
+            idleMove.active = true;
+            idleMove.processID = block.processID;
+            idleMove.tableRow = it->second;
+            idleMove.from = block.startAddress;
+            idleMove.to = target;
+            idleMove.size = block.size;
+            idleMove.copied = 0;
+            return true;
+        }
+        target += block.size;
+    }
+    return false;
+}
+
+// - HELPER FUNCTION
+// copies up to 'budget' more words of the current idle move and, once the
+// whole image is across, rebases its PCB and the queues that point at it
+// returns the number of words copied
+int continueIdleMove(vector<int>& mainMemory, queue<int>& readyQueue, int budget) {
+    // the image only moves down (to < from), so a forward copy is safe:
+    // a source word is read before the destination reaches it
+    int chunk = min(budget, idleMove.size - idleMove.copied);
+    materializeWords(mainMemory, idleMove.from + idleMove.copied, chunk);
+    copy(mainMemory.begin() + idleMove.from + idleMove.copied,
+         mainMemory.begin() + idleMove.from + idleMove.copied + chunk,
+         mainMemory.begin() + idleMove.to + idleMove.copied);
+    stampWords(idleMove.to + idleMove.copied, chunk);
+    idleMove.copied += chunk;
+    idleCompactionStats.wordsMoved += chunk;
+
+    if (idleMove.copied == idleMove.size) {
+        int vacated = max(idleMove.from, idleMove.to + idleMove.size);
+        scrubFreedWords(mainMemory, vacated, idleMove.from + idleMove.size - vacated);
+        processTable.moveBlock(idleMove.tableRow, idleMove.to);
+        trackFragmentation(idleMove.from, -idleMove.size);
+        trackFragmentation(idleMove.to, idleMove.size);
+        relocatePCB(mainMemory, idleMove.to);
+
+        unordered_map<int, int> newAddressOf;
+        newAddressOf[idleMove.from] = idleMove.to;
+        retargetPCBAddresses(readyQueue, newAddressOf);
+        coalesceMemory();
 
-        // if both current and next blocks are free, merge them
-        if (current->processID == -1 && next->processID == -1) {
-            // add next block's size to current block
-            current->size += next->size;
-            // remove the next block since it's now part of the current block
-            memoryBlocks.erase(next);
-            // don't move to the next block yet, check if we can merge more
-        }
-        else {
-            // blocks can't be merged, move to the next block
-            ++current;
-        }
+        idleMove.active = false;
+        idleCompactionStats.processesMoved++;
+        cout << "Process " << idleMove.processID << " moved to address " << idleMove.to
+             << " during idle time." << endl;
     }
+    return chunk;
 }
 
 // - HELPER FUNCTION
-// loads a PCB from main memory
-// this reconstructs a PCB from its memory representation
-PCB loadPCBFromMemory(vector<int>& mainMemory, int address) {
-    PCB pcb;
-    
-    // load all PCB fields from memory
-    pcb.processID = mainMemory[address];
-    pcb.state = static_cast<ProcessState>(mainMemory[address + 1]);
-    pcb.programCounter = mainMemory[address + 2];
-    pcb.instructionBase = mainMemory[address + 3];
-    pcb.dataBase = mainMemory[address + 4];
-    pcb.memoryLimit = mainMemory[address + 5];
-    pcb.cpuCyclesUsed = mainMemory[address + 6];
-    pcb.registerValue = mainMemory[address + 7];
-    pcb.maxMemoryNeeded = mainMemory[address + 8];
-    pcb.mainMemoryBase = mainMemory[address + 9];
-    
-    // calculate parameter offset based on executed instructions
-    if (pcb.programCounter > 0) {
-        pcb.paramOffset = 0;
-        
-        // go through all executed instructions and add up their parameter counts
-        for (int i = pcb.instructionBase; i < pcb.programCounter; i++) {
-            int opcode = mainMemory[i];
-            pcb.paramOffset += getParameterCount(static_cast<InstructionType>(opcode));
+// background defragmenter: spends an idle window moving process images
+// towards low addresses, at most 'budget' words
+void idleCompact(vector<int>& mainMemory, queue<int>& readyQueue, int budget) {
+    if (!memoryAllocator->canRelocate()) {
+        return;
+    }
+    idleCompactionStats.idleWindows++;
+    while (budget > 0) {
+        if (!idleMove.active && !startIdleMove()) {
+            return; // memory is compact
         }
-    } else {
-        // process hasn't executed any instructions yet
-        pcb.paramOffset = 0;
+        budget -= continueIdleMove(mainMemory, readyQueue, budget);
     }
-    
-    return pcb;
 }
 
 // - HELPER FUNCTION
-// saves a PCB to main memory
-// this stores a PCB in memory so it can be retrieved later
-void savePCBToMemory(vector<int>& mainMemory, int address, const PCB& pcb) {
-    // store all PCB fields in memory
-    mainMemory[address] = pcb.processID;
-    mainMemory[address + 1] = static_cast<int>(pcb.state);
-    mainMemory[address + 2] = pcb.programCounter;
-    mainMemory[address + 3] = pcb.instructionBase;
-    mainMemory[address + 4] = pcb.dataBase;
-    mainMemory[address + 5] = pcb.memoryLimit;
-    mainMemory[address + 6] = pcb.cpuCyclesUsed;
-    mainMemory[address + 7] = pcb.registerValue;
-    mainMemory[address + 8] = pcb.maxMemoryNeeded;
-    mainMemory[address + 9] = pcb.mainMemoryBase;
+// completes a half done idle move at once
+// called before a process runs, an IO completes or memory is allocated,
+// since the moving image is only valid again when all of it is copied
+void finishIdleMove(vector<int>& mainMemory, queue<int>& readyQueue) {
+    if (!idleMove.active) {
+        return;
+    }
+    idleCompactionStats.finishedEarly++;
+    continueIdleMove(mainMemory, readyQueue, idleMove.size);
+}
+
+// - HELPER FUNCTION
+// loads later jobs that fit while the head job is blocked
+// memory was already coalesced for this pass, so the size index tells us
+// exactly which jobs fit the largest hole; we take the earliest of those,
+// which is the same job an in-order scan would have found first
+void backfillJobs(PendingJobQueue& pendingJobs, queue<int>& executionQueue, vector<int>& systemMemory) {
+    while (true) {
+        // respect the head job's reservation once enough jobs passed it
+        if (backfillLimit > 0 && headBypassCount >= backfillLimit) {
+            return;
+        }
+        
+        // find the earliest job that fits into the largest free block
+        long long sequence = pendingJobs.earliestFitting(largestFreeBlock(), pendingJobs.frontSequence());
+        if (sequence < 0) {
+            return; // nothing else fits
+        }
+        
+        PCB& currentJob = pendingJobs.at(sequence);
+        int requiredSpace = currentJob.maxMemoryNeeded + 10;
+        int assignedLocation = allocateMemory(currentJob.tableRow, requiredSpace);
+        if (assignedLocation == -1) {
+            return; // cannot happen, the job was picked because it fits
+        }
+        
+        headBypassCount++;
+        admissionStats.backfilled++;
+        cout << "Process " << currentJob.processID << " backfilled ahead of Process "
+             << blockedHeadID << "." << endl;
+        placeJobInMemory(currentJob, assignedLocation, requiredSpace, executionQueue, systemMemory);
+        pendingJobs.erase(sequence);
+        readJobsFromInput(pendingJobs);
+    }
 }
 
 // loads jobs from the new job queue into memory and adds them to the ready queue
 // this is called when we want to load waiting processes into memory
-void loadJobsToMemory(queue<PCB>& pendingJobs, queue<int>& executionQueue, vector<int>& systemMemory) {
-    // we'll keep track of jobs that can't be loaded right now
-    vector<PCB> deferredJobs;
-    bool memoryCombined = false;
-    
-    // process jobs until the queue is empty or we can't load any more
+// jobs are taken in arrival order; nothing is popped and pushed back, so a
+// pass only touches the jobs it actually loads plus the blocked head
+void loadJobsToMemory(PendingJobQueue& pendingJobs, queue<int>& executionQueue, vector<int>& systemMemory) {
+    // memory is about to change, so the idle compactor has to be done
+    finishIdleMove(systemMemory, executionQueue);
+
+    // swapped out processes that finished their IO get memory before new jobs
+    if (swapInsWaiting > 0) {
+        return;
+    }
+
+    // and so do processes suspended by load control
+    if (loadControl && !resumeSuspendedProcesses(executionQueue)) {
+        return;
+    }
+
+    // load jobs from the head until the queue is empty or the head does not fit
+    readJobsFromInput(pendingJobs);
     while (!pendingJobs.empty()) {
         // get the next job from the queue
-        PCB currentJob = pendingJobs.front();
-        pendingJobs.pop();
+        PCB& currentJob = pendingJobs.front();
         
         // calculate how much memory this job needs (including PCB overhead)
         int requiredSpace = currentJob.maxMemoryNeeded + 10;  // 10 for PCB metadata
         
         // try to allocate memory for this job
-        int assignedLocation = allocateMemory(currentJob.processID, requiredSpace);
+        int assignedLocation = allocateMemory(currentJob.tableRow, requiredSpace);
+        bool memoryCombined = false;
+        
+        // with demand paging, page something out to make room for the PCB page
+        if (assignedLocation == -1 && pageReplacer != NULL && evictForAdmission(systemMemory)) {
+            assignedLocation = allocateMemory(currentJob.tableRow, requiredSpace);
+        }
         
         // if allocation failed, try to coalesce memory and try again
         if (assignedLocation == -1) {
             cout << "Insufficient memory for Process " << currentJob.processID 
                  << ". Attempting memory coalescing." << endl;
             
-            // try to combine adjacent free memory blocks
-            coalesceMemory();
+            // try to combine adjacent free memory blocks and allocate again
+            // (allocators that merge on release have nothing left to combine)
             memoryCombined = true;
+            if (!memoryAllocator->coalescesOnRelease()) {
+                coalesceMemory();
+                assignedLocation = allocateMemory(currentJob.tableRow, requiredSpace);
+            }
+            
+            // if the job fits in the free memory as a whole, compact it into one block
+            if (assignedLocation == -1 && compactionEnabled &&
+                memoryAllocator->freeWords() >= requiredSpace &&
+                compactMemory(systemMemory, executionQueue)) {
+                assignedLocation = allocateMemory(currentJob.tableRow, requiredSpace);
+            }
             
-            // try allocating memory again
-            assignedLocation = allocateMemory(currentJob.processID, requiredSpace);
+            // if that was not enough, let the swapper make room
+            if (assignedLocation == -1 && swappingEnabled &&
+                swapOutWaitingProcesses(systemMemory, requiredSpace)) {
+                assignedLocation = allocateMemory(currentJob.tableRow, requiredSpace);
+            }
             
-            // if still no space, defer this job and all remaining jobs
+            // if still no space, the head job and everything behind it waits
             if (assignedLocation == -1) {
                 cout << "Process " << currentJob.processID 
                      << " waiting in NewJobQueue due to insufficient memory." << endl;
+                admissionStats.deferrals++;
                 
-                // save this job for later
-                deferredJobs.push_back(currentJob);
-                
-                // also save all remaining jobs
-                while (!pendingJobs.empty()) {
-                    deferredJobs.push_back(pendingJobs.front());
-                    pendingJobs.pop();
+                // in backfill mode remember who is blocked and look further back
+                if (backfillAdmission) {
+                    if (blockedHeadID != currentJob.processID) {
+                        blockedHeadID = currentJob.processID;
+                        headBypassCount = 0;
+                    }
+                    backfillJobs(pendingJobs, executionQueue, systemMemory);
                 }
                 
                 // stop processing jobs for now
-                break;
+                return;
             }
         }
         
-        // if we successfully allocated memory
-        if (assignedLocation != -1) {
-            // if we had to coalesce memory, print a message
-            if (memoryCombined) {
-                cout << "Memory coalesced. Process " << currentJob.processID 
-                     << " can now be loaded." << endl;
-                memoryCombined = false;  // reset for next job
-            }
-            
-            // set up memory layout for this job
-            currentJob.mainMemoryBase = assignedLocation;
-            currentJob.instructionBase = assignedLocation + 10;  // PCB takes 10 slots
-            
-            // calculate where data starts (after all instructions)
-            int instructionCount = currentJob.instructions.size();
-            currentJob.dataBase = currentJob.instructionBase + instructionCount;
-            
-            // save the PCB to memory
-            savePCBToMemory(systemMemory, assignedLocation, currentJob);
-            
-            // first store all instruction opcodes
-            int memoryIndex = currentJob.instructionBase;
-            for (size_t i = 0; i < currentJob.instructions.size(); i++) {
-                systemMemory[memoryIndex++] = static_cast<int>(currentJob.instructions[i].type);
-            }
-            
-            // then store all instruction parameters
-            for (size_t i = 0; i < currentJob.instructions.size(); i++) {
-                const vector<int>& paramList = currentJob.instructions[i].parameters;
-                for (size_t j = 0; j < paramList.size(); j++) {
-                    systemMemory[memoryIndex++] = paramList[j];
-                }
-            }
-            
-            // print a message that job was loaded
-            cout << "Process " << currentJob.processID << " loaded into memory at address "
-                 << assignedLocation << " with size " << requiredSpace << "." << endl;
-            
-            // add to execution queue (ready queue)
-            executionQueue.push(currentJob.mainMemoryBase);
+        // if we had to coalesce memory, print a message
+        if (memoryCombined) {
+            cout << "Memory coalesced. Process " << currentJob.processID 
+                 << " can now be loaded." << endl;
         }
-    }
-    
-    // return deferred jobs to the pending queue in original order
-    for (size_t i = 0; i < deferredJobs.size(); i++) {
-        pendingJobs.push(deferredJobs[i]);
+        
+        // the head job got in, so any reservation it held is released
+        if (currentJob.processID == blockedHeadID) {
+            blockedHeadID = -1;
+            headBypassCount = 0;
+        }
+        
+        placeJobInMemory(currentJob, assignedLocation, requiredSpace, executionQueue, systemMemory);
+        pendingJobs.pop_front();
+        
+        // in streaming mode, pull the next job in as this one leaves
+        readJobsFromInput(pendingJobs);
     }
 }
 
@@ -403,6 +5130,23 @@ void loadJobsToMemory(queue<PCB>& pendingJobs, queue<int>& executionQueue, vecto
 void checkIOWaitingQueue(queue<int>& readyQueue, vector<int>& mainMemory) {
     // create a temporary queue for operations that need to keep waiting
     queue<IOWaitItem> stillWaiting;
+    swapInsWaiting = 0;
+
+    // a completing IO touches a PCB (or swaps an image in), so the idle
+    // compactor has to be done first
+    if (idleMove.active) {
+        int waitingCount = ioWaitingQueue.size();
+        bool anyCompleted = false;
+        for (int i = 0; i < waitingCount; i++) {
+            IOWaitItem item = ioWaitingQueue.front();
+            ioWaitingQueue.pop();
+            anyCompleted = anyCompleted || (globalClock - item.entryTime >= item.waitDuration);
+            ioWaitingQueue.push(item);
+        }
+        if (anyCompleted) {
+            finishIdleMove(mainMemory, readyQueue);
+        }
+    }
     
     // process all items in the IO waiting queue
     while (!ioWaitingQueue.empty()) {
@@ -413,6 +5157,27 @@ void checkIOWaitingQueue(queue<int>& readyQueue, vector<int>& mainMemory) {
         // check if this operation has been waiting long enough
         bool isCompleted = (globalClock - currentItem.entryTime >= currentItem.waitDuration);
         
+        // a swapped out process has to come back into memory first
+        if (isCompleted && currentItem.pcbAddress == -1) {
+            currentItem.pcbAddress = swapInProcess(mainMemory, currentItem.tableRow);
+            if (currentItem.pcbAddress == -1) {
+                swapStats.swapInStalls++;
+                swapInsWaiting++;
+                stillWaiting.push(currentItem);
+                continue;
+            }
+        }
+        
+        // a page fault only has to make the process ready again
+        if (isCompleted && currentItem.pageFault) {
+            PCB process = loadPCBFromMemory(mainMemory, currentItem.pcbAddress);
+            process.state = STATE_READY;
+            savePCBToMemory(mainMemory, currentItem.pcbAddress, process);
+            cout << "Process " << process.processID << " page fault serviced and is moved to the ReadyQueue." << endl;
+            readyQueue.push(currentItem.pcbAddress);
+            continue;
+        }
+        
         if (isCompleted) {
             // the IO operation is complete, get the process
             int pcbAddress = currentItem.pcbAddress;
@@ -422,7 +5187,7 @@ void checkIOWaitingQueue(queue<int>& readyQueue, vector<int>& mainMemory) {
             cout << "print" << endl;
             
             // update the process state
-            int waitCycles = mainMemory[process.dataBase + process.paramOffset];
+            int waitCycles = readWord(mainMemory, process.tableRow, process.dataBase + process.paramOffset);
             process.cpuCyclesUsed += waitCycles;
             process.programCounter++;
             process.paramOffset += getParameterCount(PRINT);
@@ -446,9 +5211,187 @@ void checkIOWaitingQueue(queue<int>& readyQueue, vector<int>& mainMemory) {
     ioWaitingQueue = stillWaiting;
 }
 
+// - HELPER FUNCTION
+// records a finished cpu burst and, in adaptive mode, retunes the quantum
+// the new quantum is the chosen percentile of the recent bursts, kept
+// inside the user bounds, so most bursts finish without a timeout
+void recordCPUBurst(int row, int cyclesThisRun) {
+    int burst = processTable.burstCycles[row] + cyclesThisRun;
+    processTable.burstCycles[row] = 0;
+    if (!adaptiveQuantum || burst <= 0) {
+        return;
+    }
+
+    // slide the window forward
+    recentBursts.push_back(burst);
+    if (static_cast<int>(recentBursts.size()) > quantumWindow) {
+        recentBursts.pop_front();
+    }
+
+    // wait for a few samples before trusting the distribution
+    if (recentBursts.size() < 4 && static_cast<int>(recentBursts.size()) < quantumWindow) {
+        return;
+    }
+
+    // find the percentile without sorting the whole window
+    vector<int> samples(recentBursts.begin(), recentBursts.end());
+    size_t rank = (samples.size() - 1) * quantumPercentile / 100;
+    nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    int newQuantum = max(quantumMin, min(quantumMax, samples[rank]));
+
+    if (newQuantum != CPUAllocated) {
+        cout << "Time quantum adjusted from " << CPUAllocated << " to " << newQuantum
+             << " at time " << globalClock << "." << endl;
+        CPUAllocated = newQuantum;
+        schedulingStats.quantumAdjustments++;
+    }
+}
+
+// - HELPER FUNCTION
+// works out what the context switch to a process costs
+// the flat model (default) always charges contextSwitchTime; the tiered
+// model charges less when the process's state is likely still cached
+int contextSwitchCost(int row) {
+    // classify the switch
+    int processID = processTable.processID[row];
+    SwitchKind kind = SWITCH_COLD;
+    if (processID == lastDispatchedProcess) {
+        kind = SWITCH_REDISPATCH;
+    } else if (processTable.lastDispatch[row] != -1 &&
+               schedulingStats.dispatches - processTable.lastDispatch[row] <= warmSwitchWindow) {
+        kind = SWITCH_WARM;
+    }
+
+    // price it
+    int cost = contextSwitchTime;
+    if (tieredSwitchCost) {
+        if (kind == SWITCH_REDISPATCH) {
+            cost = redispatchSwitchCost;
+        } else if (kind == SWITCH_WARM) {
+            cost = (warmSwitchCost >= 0) ? warmSwitchCost : contextSwitchTime / 2;
+        } else {
+            cost = (coldSwitchCost >= 0) ? coldSwitchCost : contextSwitchTime;
+        }
+    }
+
+    // remember this dispatch for the next classification
+    schedulingStats.dispatches++;
+    schedulingStats.switchTime += cost;
+    schedulingStats.switchCount[kind]++;
+    schedulingStats.switchTimeByKind[kind] += cost;
+    processTable.lastDispatch[row] = schedulingStats.dispatches;
+    lastDispatchedProcess = processID;
+    return cost;
+}
+
+// - HELPER FUNCTION
+// prints the admission report at the end of the simulation
+// run with and without --admission=backfill to see what backfilling buys
+void printAdmissionReport(int maxMemory) {
+    updateMemoryUsage(0); // close the utilization integral at the final time
+    cout << "Admission report (" << (backfillAdmission ? "backfill" : "fifo") << "):" << endl;
+    cout << "Jobs admitted: " << admissionStats.admitted
+         << ". Backfilled: " << admissionStats.backfilled
+         << ". Deferrals: " << admissionStats.deferrals << "." << endl;
+    if (placementCheck) {
+        cout << "Loads placed differently from first fit: " << placementDifferences << "." << endl;
+    }
+    if (idleCompactBudget > 0) {
+        cout << "Idle compaction: " << idleCompactionStats.processesMoved << " processes moved ("
+             << idleCompactionStats.wordsMoved << " words) in " << idleCompactionStats.idleWindows
+             << " idle windows. Moves finished early: " << idleCompactionStats.finishedEarly << "." << endl;
+    }
+    if (lazyScrub) {
+        cout << "Lazy scrubbing: " << scrubStats.wordsFilled
+             << " words filled. " << scrubStats.wordsTagged << " words tagged. "
+             << scrubStats.wordsMaterialized << " stale words materialized." << endl;
+    }
+    if (compactionEnabled) {
+        cout << "Compactions: " << compactionStats.compactions
+             << ". Processes moved: " << compactionStats.processesMoved
+             << ". Words moved: " << compactionStats.wordsMoved << "." << endl;
+    }
+    if (admissionStats.admitted > 0) {
+        cout << "Average wait in NewJobQueue: "
+             << (static_cast<double>(admissionStats.totalAdmissionWait) / admissionStats.admitted)
+             << "." << endl;
+    }
+    if (globalClock > 0) {
+        cout << "Average memory utilization: "
+             << (100.0 * admissionStats.usageArea / (static_cast<double>(maxMemory) * globalClock))
+             << "%." << endl;
+        cout << "Throughput: " << (1000.0 * schedulingStats.terminated / globalClock)
+             << " processes per 1000 time units." << endl;
+    }
+}
+
+// - HELPER FUNCTION
+// prints the scheduling report at the end of the simulation
+// run once with the defaults and once with the new modes to compare
+void printSchedulingReport() {
+    cout << "Scheduling report (" << (adaptiveQuantum ? "adaptive" : "fixed") << " quantum):" << endl;
+    cout << "Context switches: " << schedulingStats.dispatches
+         << ". Time spent switching: " << schedulingStats.switchTime << "." << endl;
+    cout << "Switch cost model: " << (tieredSwitchCost ? "tiered" : "flat") << "." << endl;
+    const char* kindNames[3] = { "Re-dispatch", "Warm", "Cold" };
+    for (int i = 0; i < 3; i++) {
+        cout << kindNames[i] << " switches: " << schedulingStats.switchCount[i]
+             << ". Time: " << schedulingStats.switchTimeByKind[i] << "." << endl;
+    }
+    cout << "TimeOUT interrupts: " << schedulingStats.timeouts << "." << endl;
+    if (schedulingStats.terminated > 0) {
+        cout << "Average turnaround time: "
+             << (static_cast<double>(schedulingStats.totalTurnaround) / schedulingStats.terminated)
+             << "." << endl;
+    }
+    if (adaptiveQuantum) {
+        cout << "Quantum adjustments: " << schedulingStats.quantumAdjustments
+             << ". Final quantum: " << CPUAllocated << "." << endl;
+    }
+}
+
+// picks the next process to run and removes it from the ready queue
+// round robin takes the front of the queue, EDF takes the ready process
+// with the earliest absolute deadline (ties keep their queue order)
+int selectNextProcess(queue<int>& readyQueue) {
+    if (schedulingPolicy != "edf") {
+        int startAddress = readyQueue.front();
+        readyQueue.pop();
+        return startAddress;
+    }
+
+    // rotate through the whole queue once, remembering the best candidate
+    int queueSize = readyQueue.size();
+    int bestIndex = 0;
+    int bestDeadline = INT_MAX;
+    for (int i = 0; i < queueSize; i++) {
+        int address = readyQueue.front();
+        int deadline = getDeadline(processTable.rowAt(address));
+        if (deadline < bestDeadline) {
+            bestDeadline = deadline;
+            bestIndex = i;
+        }
+        readyQueue.pop();
+        readyQueue.push(address);
+    }
+
+    // rotate again, taking the chosen process out and keeping the others in order
+    int chosenAddress = -1;
+    for (int i = 0; i < queueSize; i++) {
+        int address = readyQueue.front();
+        readyQueue.pop();
+        if (i == bestIndex) {
+            chosenAddress = address;
+        } else {
+            readyQueue.push(address);
+        }
+    }
+    return chosenAddress;
+}
+
 // executes a process on the CPU
 // this simulates the CPU executing instructions for a process
-void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQueue, queue<int>& readyQueue) {
+void executeCPU(int startAddress, vector<int>& mainMemory, PendingJobQueue& newJobQueue, queue<int>& readyQueue) {
     
     // load the process from memory
     PCB process = loadPCBFromMemory(mainMemory, startAddress);
@@ -459,7 +5402,11 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
     savePCBToMemory(mainMemory, startAddress, process);
 
     // add time for context switching
-    globalClock += contextSwitchTime;
+    int row = process.tableRow;
+    if (tlbEntries > 0) {
+        tlb.switchTo(process.processID);
+    }
+    globalClock += contextSwitchCost(row);
 
     // if this is the first time running this process
     if (process.programCounter == 0) {
@@ -468,7 +5415,8 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
         // initialize parameter offset to 0
         process.paramOffset = 0;
         // record when the process first starts running
-        processStartTimes[process.processID] = globalClock;
+        processTable.startTime[row] = globalClock;
+        schedulingStats.totalResponse += globalClock - getArrivalTime(row);
     }
 
     // set the process state to RUNNING
@@ -478,8 +5426,31 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
 
     // main execution loop - execute instructions until completion or timeout
     while (process.programCounter < process.dataBase && cpuCyclesThisRun < CPUAllocated) {
+        // with demand paging, wait for the pages this instruction needs
+        if (pageReplacer != NULL) {
+            int missingPage;
+            int faultWait = servicePageFaults(mainMemory, process, missingPage);
+            if (faultWait == SUSPEND_FOR_LOAD_CONTROL) {
+                process.state = STATE_READY;
+                savePCBToMemory(mainMemory, startAddress, process);
+                suspendProcess(mainMemory, row, startAddress);
+                recordCPUBurst(row, cpuCyclesThisRun);
+                return;
+            }
+            if (faultWait > 0) {
+                cout << "Process " << process.processID << " page fault on page " << missingPage
+                     << " and moved to the IOWaitingQueue." << endl;
+                process.state = STATE_IOWAITING;
+                savePCBToMemory(mainMemory, startAddress, process);
+                ioWaitingQueue.push(IOWaitItem(startAddress, faultWait, globalClock, process.processID, row, true));
+                recordCPUBurst(row, cpuCyclesThisRun);
+                return;
+            }
+        }
+
         // get the current instruction
-        int instructionCode = mainMemory[process.programCounter];
+        int instructionCode = readWord(mainMemory, row, process.programCounter, FETCH_ACCESS);
+        pagingStats.instructions++;
         InstructionType currentOperation = static_cast<InstructionType>(instructionCode);
         
         // calculate where this instruction's parameters are located
@@ -489,8 +5460,8 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
         switch (currentOperation) {
             case COMPUTE: {
                 // compute instruction: uses iterations and cycles parameters
-                int iterationCount = mainMemory[paramStartPos];
-                int cycleDuration = mainMemory[paramStartPos + 1];
+                int iterationCount = readWord(mainMemory, row, paramStartPos, FETCH_ACCESS);
+                int cycleDuration = readWord(mainMemory, row, paramStartPos + 1, FETCH_ACCESS);
                 
                 // print what we're doing
                 cout << "compute" << endl;
@@ -508,7 +5479,7 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
             
             case PRINT: {
                 // print instruction: uses cycles parameter
-                int ioDuration = mainMemory[paramStartPos];
+                int ioDuration = readWord(mainMemory, row, paramStartPos, FETCH_ACCESS);
                 
                 // print a message about the IO interrupt
                 cout << "Process " << process.processID 
@@ -519,7 +5490,10 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
                 savePCBToMemory(mainMemory, startAddress, process);
                 
                 // add to IO waiting queue
-                ioWaitingQueue.push(IOWaitItem(startAddress, ioDuration, globalClock));
+                ioWaitingQueue.push(IOWaitItem(startAddress, ioDuration, globalClock, process.processID, row));
+
+                // the cpu burst ends here
+                recordCPUBurst(row, cpuCyclesThisRun);
                 
                 // stop executing this process for now
                 return;
@@ -527,20 +5501,28 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
             
             case STORE: {
                 // store instruction: uses value and address parameters
-                int valueToStore = mainMemory[paramStartPos];
-                int targetLocation = mainMemory[paramStartPos + 1];
+                int valueToStore = readWord(mainMemory, row, paramStartPos, FETCH_ACCESS);
+                int targetLocation = readWord(mainMemory, row, paramStartPos + 1, FETCH_ACCESS);
                 
                 // update the register with the value
                 process.registerValue = valueToStore;
                 
                 // check if the address is valid
-                bool validAddress = (targetLocation < process.memoryLimit);
+                bool validAddress = (targetLocation >= 0 && targetLocation < process.memoryLimit);
+                
+                // a page or segment shared with another process needs a private copy first
+                if (validAddress && !copyOnWrite(mainMemory, row, process.mainMemoryBase + targetLocation)) {
+                    validAddress = false;
+                }
                 
                 if (validAddress) {
                     // calculate the actual memory address
                     int actualAddress = process.mainMemoryBase + targetLocation;
                     // store the value in memory
-                    mainMemory[actualAddress] = valueToStore;
+                    writeWord(mainMemory, row, actualAddress, valueToStore, DATA_ACCESS);
+                    if (actualAddress >= process.instructionBase && actualAddress <= process.programCounter) {
+                        processTable.opcodesRewritten[row] = 1;
+                    }
                     cout << "stored" << endl;
                 } else {
                     // address is invalid
@@ -557,18 +5539,37 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
                 break;
             }
             
+            case FORK: {
+                // fork instruction: starts a child that continues after the FORK
+                int childID = forkProcess(mainMemory, process, readyQueue);
+                if (childID != -1) {
+                    cout << "Process " << process.processID << " forked Process " << childID << "." << endl;
+                } else {
+                    cout << "fork error!" << endl;
+                }
+                
+                // the parent gets the child's ID (-1 if the fork failed)
+                process.registerValue = childID;
+                
+                // update the execution time
+                process.cpuCyclesUsed++;
+                cpuCyclesThisRun++;
+                globalClock++;
+                break;
+            }
+            
             case LOAD: {
                 // load instruction: uses address parameter
-                int sourceLocation = mainMemory[paramStartPos];
+                int sourceLocation = readWord(mainMemory, row, paramStartPos, FETCH_ACCESS);
                 
                 // check if the address is valid
-                bool validAddress = (sourceLocation < process.memoryLimit);
+                bool validAddress = (sourceLocation >= 0 && sourceLocation < process.memoryLimit);
                 
                 if (validAddress) {
                     // calculate the actual memory address
                     int actualAddress = process.mainMemoryBase + sourceLocation;
                     // load the value from memory into the register
-                    process.registerValue = mainMemory[actualAddress];
+                    process.registerValue = readWord(mainMemory, row, actualAddress, DATA_ACCESS);
                     cout << "loaded" << endl;
                 } else {
                     // address is invalid
@@ -607,6 +5608,10 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
             savePCBToMemory(mainMemory, startAddress, process);
             timeoutOccurred = true;
             readyQueue.push(startAddress);
+
+            // the cpu burst continues in the next time slice
+            processTable.burstCycles[row] += cpuCyclesThisRun;
+            schedulingStats.timeouts++;
             return;
         }
     }
@@ -631,98 +5636,447 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<PCB>& newJobQue
     cout << "Register Value: " << process.registerValue << endl;
     cout << "Max Memory Needed: " << process.maxMemoryNeeded << endl;
     cout << "Main Memory Base: " << process.mainMemoryBase << endl;
-    cout << "Total CPU Cycles Consumed: " << (globalClock - processStartTimes[process.processID]) << endl;
+    int startTime = processTable.startTime[row];
+    cout << "Total CPU Cycles Consumed: " << (globalClock - startTime) << endl;
+    if (tlbEntries > 0) {
+        long long lookups = processTable.tlbHits[row] + processTable.tlbMisses[row];
+        cout << "TLB hits: " << processTable.tlbHits[row] << ". TLB misses: " << processTable.tlbMisses[row]
+             << ". Hit rate: " << (lookups > 0 ? 100.0 * processTable.tlbHits[row] / lookups : 0.0) << "%." << endl;
+        TLBProcessCounts counts;
+        counts.processID = process.processID;
+        counts.hits = processTable.tlbHits[row];
+        counts.misses = processTable.tlbMisses[row];
+        tlbProcessCounts.push_back(counts);
+    }
 
     // print a termination message with timing information
-    cout << "Process " << process.processID<< " terminated. Entered running state at: "<< processStartTimes[process.processID]<< ". Terminated at: "<< globalClock<< ". Total Execution Time: "<< (globalClock - processStartTimes[process.processID])<< "." << endl;
+    cout << "Process " << process.processID<< " terminated. Entered running state at: "<< startTime<< ". Terminated at: "<< globalClock<< ". Total Execution Time: "<< (globalClock - startTime)<< "." << endl;
+
+    // account for the deadline (if this process had one)
+    recordDeadlineResult(row, process.cpuCyclesUsed);
+
+    // the last cpu burst ends with the process
+    recordCPUBurst(row, cpuCyclesThisRun);
+    schedulingStats.terminated++;
+    schedulingStats.totalTurnaround += globalClock - getArrivalTime(row);
+    arrivalStats.totalCPUCycles += process.cpuCyclesUsed;
 
-    // free the memory used by this process
+    // free the memory used by this process and its table row
     int freedStart = process.mainMemoryBase;
     int freedSize = process.maxMemoryNeeded + 10;
-    freeMemory(mainMemory, process.processID);
+    long long allocatedBefore = admissionStats.allocatedWords; // segments still shared stay allocated
+    const vector<int>& freedTable = processTable.pageTable[row];
+    int freedFrames = 0;
+    for (size_t page = 0; page < freedTable.size(); page++) {
+        // frames still shared with a forked relative stay in use
+        if (freedTable[page] != -1 && (pageReplacer != NULL || frameRefs[freedTable[page]] == 1)) {
+            freedFrames++;
+        }
+    }
+    freeMemory(mainMemory, row);
+    processTable.releaseRow(row);
+    long long freedSegmentWords = allocatedBefore - admissionStats.allocatedWords;
     
     // print a message about freed memory
-    cout << "Process " << process.processID << " terminated and released memory from "
-         << freedStart << " to "
-         << (freedStart + freedSize - 1) << "." << endl;
+    if (pageSize > 0) {
+        cout << "Process " << process.processID << " terminated and released " << freedFrames
+             << " frames." << endl;
+    } else if (segmentedMemory) {
+        cout << "Process " << process.processID << " terminated and released " << freedSegmentWords
+             << " words of its segments." << endl;
+    } else {
+        cout << "Process " << process.processID << " terminated and released memory from "
+             << freedStart << " to "
+             << (freedStart + freedSize - 1) << "." << endl;
+    }
          
     // set flag so we know memory was freed
     memoryFreed = true;
 }
 
+// - HELPER FUNCTION
+// checks if a command line argument has the form --name=value
+// and if so hands back the value part
+bool matchOption(const string& arg, const string& name, string& value) {
+    if (arg.compare(0, name.size() + 1, name + "=") != 0) {
+        return false;
+    }
+    value = arg.substr(name.size() + 1);
+    return true;
+}
+
 // main program entry point
-int main() {
+// optional flags:
+//   --deadlines              each process record has a relative deadline after its memory size
+//   --scheduler=edf          dispatch by earliest deadline first (implies --deadlines)
+//   --quantum=adaptive       retune CPUAllocated from the recent cpu burst distribution
+//   --quantum-percentile=N   burst percentile the adaptive quantum targets (default 80)
+//   --quantum-min=N          lower bound for the adaptive quantum (default 1)
+//   --quantum-max=N          upper bound for the adaptive quantum (default unbounded)
+//   --quantum-window=N       number of recent bursts considered (default 32)
+//   --switch-model=tiered    charge re-dispatch, warm and cold context switches differently
+//   --switch-redispatch=N    cost of running the same process again right away (default 0)
+//   --switch-warm=N          cost of switching to a recently run process (default half)
+//   --switch-cold=N          cost of any other switch (default contextSwitchTime)
+//   --switch-warm-window=N   dispatches of other processes a warm process may wait (default 3)
+//   --admission=backfill     load later jobs that fit while the head job waits for memory
+//   --backfill-limit=N       jobs that may pass a blocked head before it reserves memory (0: no limit)
+//   --swap                   swap out IO waiting processes when a new job does not fit
+//   --swap-after=N           IO wait time before a process may be swapped out (default 10)
+//   --swap-file=PATH         backing store for swapped out images, kept after the run
+//                            (default swapfile.bin, removed at the end)
+//   --arrivals=input         each process record has an arrival time after its deadline/memory size
+//   --arrivals=poisson:GAP   generate arrivals with exponential gaps of mean GAP
+//   --arrivals=bursty:ON,OFF,GAP  poisson arrivals (mean gap GAP) only during ON of every ON+OFF
+//   --arrivals=periodic:GAP  one arrival every GAP time units
+//   --arrival-seed=N         seed for the random arrival generators (default 1)
+//   --stream                 read process records lazily as admission needs them
+//   --stream-window=N        streaming mode: read jobs allowed to wait for memory (default 1,
+//                            raise it so --admission=backfill has jobs to look at)
+//   --allocator=NAME         memory allocator: first-fit (default), next-fit, best-fit, worst-fit,
+//                            indexed (best fit over address/size trees, merges on free),
+//                            tlsf (two-level segregated fit, O(1) free, O(1) allocate
+//                            except near full memory, where it walks one size class list),
+//                            buddy (power of two blocks, split and merged with their buddies),
+//                            bitmap (first fit over a bit per word, for very large memories)
+//   --compact                when a job fits in the free memory but in no single hole, slide
+//                            the loaded processes together (not with --allocator=buddy)
+//   --idle-compact=N         move process images together in idle time, at most N words per
+//                            idle time unit, so holes merge before the next admission
+//   --paging=N               paged memory: images go into any free frames of N words (a power
+//                            of two, at least 16) and process addresses go through page tables
+//                            (not with --swap, --compact, --idle-compact or --frag-out)
+//   --tlb=N                  paged memory: translate process accesses through an N entry TLB
+//   --tlb-ways=N             TLB associativity (default: fully associative)
+//   --tlb-policy=NAME        TLB replacement: lru (default), fifo or random
+//   --tlb-asid               tag TLB entries with the process instead of flushing on a switch
+//   --tlb-miss-cycles=N      time charged on the clock for each TLB miss (default 10)
+//   --demand-paging=POLICY   paged memory: admit jobs with only their PCB page resident and
+//                            bring the other pages in on first use, replacing pages with
+//                            clock, lru, fifo or arc (needs at least 5 frames)
+//   --fault-time=N           demand paging: IO wait per page read or written (default 20)
+//   --page-file=PATH         demand paging: backing store for pages, kept after the run
+//                            (default pagefile.bin, removed at the end)
+//   --load-control           demand paging: admit jobs and suspend faulting processes so the
+//                            working sets of the active processes fit in memory
+//   --ws-window=N            demand paging: page references a working set covers (default 64)
+//   --segments               segmented memory: each image gets a code segment (opcodes and
+//                            parameters) and a data segment (PCB and the rest); jobs with
+//                            identical code share one code segment (not with --paging, --swap,
+//                            --compact, --idle-compact or --trace-out)
+//   --scrub=lazy             tag freed memory with an epoch instead of writing -1 into every
+//                            word; stale words read as -1 until they are written again
+//   --tlsf-compat            mark loads whose address differs from what first fit would pick
+//   --bench=LIST             benchmark allocators (comma separated names, or "placement")
+//                            on a synthetic workload instead of simulating; tune it with
+//                            --bench-memory=N[,N...] --bench-jobs=N --bench-sizes=MIN,MAX
+//                            --bench-lifetimes=MIN,MAX --bench-seed=N
+//   --bench-trace=PATH       benchmark: replay a trace written with --trace-out instead
+//   --trace-out=PATH         write every allocation, free and coalesce of the run to PATH
+//   --frag-out=PATH          write a CSV time series of free words, largest hole, hole count,
+//                            external fragmentation and a hole size histogram to PATH
+//   --frag-every=N           time units between fragmentation samples (default 100)
+//   --stats                  print the scheduling and admission reports in every mode
+int main(int argc, char* argv[]) {
+    // read simulator options from the command line
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string value;
+        if (arg == "--deadlines") {
+            readDeadlines = true;
+        } else if (arg == "--scheduler=edf" || arg == "--scheduler=rr") {
+            schedulingPolicy = arg.substr(arg.find('=') + 1);
+            if (schedulingPolicy == "edf") {
+                readDeadlines = true;
+            }
+        } else if (arg == "--quantum=adaptive" || arg == "--quantum=fixed") {
+            adaptiveQuantum = (arg == "--quantum=adaptive");
+        } else if (matchOption(arg, "--quantum-percentile", value)) {
+            quantumPercentile = max(0, min(100, atoi(value.c_str())));
+        } else if (matchOption(arg, "--quantum-min", value)) {
+            quantumMin = max(1, atoi(value.c_str()));
+        } else if (matchOption(arg, "--quantum-max", value)) {
+            quantumMax = max(1, atoi(value.c_str()));
+        } else if (matchOption(arg, "--quantum-window", value)) {
+            quantumWindow = max(1, atoi(value.c_str()));
+        } else if (arg == "--switch-model=tiered" || arg == "--switch-model=flat") {
+            tieredSwitchCost = (arg == "--switch-model=tiered");
+        } else if (matchOption(arg, "--switch-redispatch", value)) {
+            redispatchSwitchCost = max(0, atoi(value.c_str()));
+        } else if (matchOption(arg, "--switch-warm", value)) {
+            warmSwitchCost = max(0, atoi(value.c_str()));
+        } else if (matchOption(arg, "--switch-cold", value)) {
+            coldSwitchCost = max(0, atoi(value.c_str()));
+        } else if (matchOption(arg, "--switch-warm-window", value)) {
+            warmSwitchWindow = max(0, atoi(value.c_str()));
+        } else if (arg == "--admission=backfill" || arg == "--admission=fifo") {
+            backfillAdmission = (arg == "--admission=backfill");
+        } else if (matchOption(arg, "--backfill-limit", value)) {
+            backfillLimit = max(0, atoi(value.c_str()));
+        } else if (arg == "--swap") {
+            swappingEnabled = true;
+        } else if (arg == "--compact") {
+            compactionEnabled = true;
+        } else if (matchOption(arg, "--paging", value)) {
+            pageSize = atoi(value.c_str());
+            if (pageSize < 16 || (pageSize & (pageSize - 1)) != 0) {
+                cerr << "Page size must be a power of two of at least 16 words" << endl;
+                return 1;
+            }
+            pageShift = __builtin_ctz(pageSize);
+        } else if (matchOption(arg, "--tlb", value)) {
+            tlbEntries = max(0, atoi(value.c_str()));
+        } else if (matchOption(arg, "--tlb-ways", value)) {
+            tlbWays = max(0, atoi(value.c_str()));
+        } else if (arg == "--tlb-policy=lru" || arg == "--tlb-policy=fifo" || arg == "--tlb-policy=random") {
+            tlbPolicy = arg.substr(arg.find('=') + 1);
+        } else if (arg == "--tlb-asid") {
+            tlbASIDs = true;
+        } else if (matchOption(arg, "--tlb-miss-cycles", value)) {
+            tlbMissCycles = max(0, atoi(value.c_str()));
+        } else if (arg == "--demand-paging=clock" || arg == "--demand-paging=lru" ||
+                   arg == "--demand-paging=fifo" || arg == "--demand-paging=arc") {
+            demandPolicy = arg.substr(arg.find('=') + 1);
+        } else if (matchOption(arg, "--fault-time", value)) {
+            pageFaultTime = max(1, atoi(value.c_str()));
+        } else if (matchOption(arg, "--page-file", value)) {
+            pageFileName = value;
+            keepPageFile = true;
+        } else if (arg == "--load-control") {
+            loadControl = true;
+        } else if (matchOption(arg, "--ws-window", value)) {
+            workingSetWindow = max(1, atoi(value.c_str()));
+        } else if (arg == "--segments") {
+            segmentedMemory = true;
+        } else if (arg == "--scrub=lazy" || arg == "--scrub=eager") {
+            lazyScrub = (arg == "--scrub=lazy");
+        } else if (matchOption(arg, "--idle-compact", value)) {
+            idleCompactBudget = max(0, atoi(value.c_str()));
+        } else if (matchOption(arg, "--swap-after", value)) {
+            swapAfter = max(0, atoi(value.c_str()));
+        } else if (matchOption(arg, "--swap-file", value)) {
+            swapFileName = value;
+            keepSwapFile = true;
+        } else if (matchOption(arg, "--arrivals", value)) {
+            // split "mode:parameters"
+            size_t colon = value.find(':');
+            arrivalMode = value.substr(0, colon);
+            string params = (colon == string::npos) ? "" : value.substr(colon + 1);
+            if (arrivalMode == "bursty") {
+                sscanf(params.c_str(), "%d,%d,%lf", &burstOnTime, &burstOffTime, &arrivalGap);
+                burstOnTime = max(1, burstOnTime);
+                burstOffTime = max(0, burstOffTime);
+            } else if (!params.empty()) {
+                arrivalGap = atof(params.c_str());
+            }
+            arrivalGap = max(0.001, arrivalGap);
+            if (arrivalMode != "none" && arrivalMode != "input" && arrivalMode != "poisson" &&
+                arrivalMode != "bursty" && arrivalMode != "periodic") {
+                cerr << "Unknown arrival mode: " << arrivalMode << endl;
+                return 1;
+            }
+        } else if (matchOption(arg, "--arrival-seed", value)) {
+            arrivalSeed = static_cast<unsigned int>(atoi(value.c_str()));
+        } else if (arg == "--stream") {
+            streamingInput = true;
+        } else if (matchOption(arg, "--stream-window", value)) {
+            streamWindow = max(1, atoi(value.c_str()));
+        } else if (matchOption(arg, "--allocator", value)) {
+            allocatorName = value;
+        } else if (arg == "--tlsf-compat") {
+            placementCheck = true;
+        } else if (matchOption(arg, "--bench", value)) {
+            benchmarkList = value;
+        } else if (matchOption(arg, "--bench-memory", value)) {
+            benchMemorySizes.clear();
+            stringstream sizeStream(value);
+            string size;
+            while (getline(sizeStream, size, ',')) {
+                benchMemorySizes.push_back(max(1, atoi(size.c_str())));
+            }
+        } else if (matchOption(arg, "--bench-jobs", value)) {
+            benchJobs = max(1, atoi(value.c_str()));
+        } else if (matchOption(arg, "--bench-sizes", value)) {
+            sscanf(value.c_str(), "%d,%d", &benchMinSize, &benchMaxSize);
+            benchMinSize = max(1, benchMinSize);
+            benchMaxSize = max(benchMinSize, benchMaxSize);
+        } else if (matchOption(arg, "--bench-lifetimes", value)) {
+            sscanf(value.c_str(), "%d,%d", &benchMinLife, &benchMaxLife);
+            benchMinLife = max(1, benchMinLife);
+            benchMaxLife = max(benchMinLife, benchMaxLife);
+        } else if (matchOption(arg, "--bench-trace", value)) {
+            benchTraceName = value;
+        } else if (matchOption(arg, "--frag-out", value)) {
+            fragmentationFileName = value;
+        } else if (matchOption(arg, "--frag-every", value)) {
+            fragmentationEvery = max(1, atoi(value.c_str()));
+        } else if (matchOption(arg, "--trace-out", value)) {
+            traceFileName = value;
+        } else if (matchOption(arg, "--bench-seed", value)) {
+            benchSeed = static_cast<unsigned int>(atoi(value.c_str()));
+        } else if (arg == "--stats") {
+            printStats = true;
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+
     // declare variables for memory and process management
     int maxMemory, numProcesses;
-    queue<PCB> newJobQueue; // queue for processes waiting to be loaded into memory
+    PendingJobQueue newJobQueue; // queue for processes waiting to be loaded into memory
     queue<int> readyQueue;  // queue for processes ready to execute
     vector<int> mainMemory; // simulated main memory
 
+    // benchmark mode does not simulate anything
+    if (!benchmarkList.empty()) {
+        return runAllocatorBenchmark(benchmarkList);
+    }
+
+    // paged memory has no contiguous images to swap or slide, and no holes
+    if (pageSize > 0 && (swappingEnabled || compactionEnabled || idleCompactBudget > 0 ||
+                         !fragmentationFileName.empty())) {
+        cerr << "--paging cannot be combined with --swap, --compact, --idle-compact or --frag-out" << endl;
+        return 1;
+    }
+    // segments are not one block that could be swapped, slid or traced
+    if (segmentedMemory && (pageSize > 0 || swappingEnabled || compactionEnabled || idleCompactBudget > 0 ||
+                            !traceFileName.empty())) {
+        cerr << "--segments cannot be combined with --paging, --swap, --compact, --idle-compact or --trace-out"
+             << endl;
+        return 1;
+    }
+    if (tlbEntries > 0 && pageSize == 0) {
+        cerr << "--tlb needs --paging" << endl;
+        return 1;
+    }
+    if (!demandPolicy.empty() && pageSize == 0) {
+        cerr << "--demand-paging needs --paging" << endl;
+        return 1;
+    }
+    if (loadControl && demandPolicy.empty()) {
+        cerr << "--load-control needs --demand-paging" << endl;
+        return 1;
+    }
+    if (tlbEntries > 0) {
+        tlb.init();
+    }
+
+    // check the allocator name before reading any input
+    MemoryAllocator* probe = createAllocator(allocatorName, 1);
+    if (probe == NULL) {
+        cerr << "Unknown allocator: " << allocatorName << endl;
+        return 1;
+    }
+    delete probe;
+
     // read input parameters from standard input
     cin >> maxMemory >> CPUAllocated >> contextSwitchTime >> numProcesses;
     
     // initialize main memory with -1 (representing empty memory)
     mainMemory.resize(maxMemory, -1);
+    if (lazyScrub) {
+        wordEpoch.assign(maxMemory, 0);
+        chunkFreeEpoch.assign(maxMemory / SCRUB_CHUNK_WORDS + 1, 0);
+    }
+    arrivalRandom.seed(arrivalSeed);
+
+    // open (and empty) the backing store for the swapper
+    if (swappingEnabled) {
+        swapFile.open(swapFileName.c_str(), ios::in | ios::out | ios::binary | ios::trunc);
+        if (!swapFile) {
+            cerr << "Cannot open swap file " << swapFileName << endl;
+            return 1;
+        }
+    }
     
-    // initialize memory blocks list with one big free block
-    memoryBlocks.push_back(MemoryBlock(-1, 0, maxMemory));
+    // create the allocator (the default first fit list starts as one big free block)
+    memoryAllocator = createAllocator(allocatorName, maxMemory);
 
-    // read data for each process
-    for (int i = 0; i < numProcesses; i++) {
-        // create a new process control block
-        PCB process;
-        int numInstructions;
-
-        // read process ID, memory needed, and number of instructions
-        cin >> process.processID >> process.maxMemoryNeeded >> numInstructions;
-        process.state = STATE_NEW;
-        process.memoryLimit = process.maxMemoryNeeded;
-
-        // read and store all instructions for this process
-        for (int j = 0; j < numInstructions; j++) {
-            // read the instruction opcode
-            int rawOpcode;
-            cin >> rawOpcode;
-            // convert to instruction type
-            InstructionType operationType = static_cast<InstructionType>(rawOpcode);
-            
-            // create a new instruction
-            Instruction currentCmd(operationType);
-            // determine how many parameters this instruction requires
-            int requiredArgCount = getParameterCount(operationType);
+    // with paging every whole frame starts out free (a partial frame at the end is not used)
+    for (int frame = (maxMemory >> pageShift) - 1; pageSize > 0 && frame >= 0; frame--) {
+        freeFrames.push_back(frame);
+    }
+    if (pageSize > 0) {
+        frameRefs.assign(maxMemory >> pageShift, 0);
+    }
 
-            // read all parameters for this instruction
-            for (int argIndex = 0; argIndex < requiredArgCount; argIndex++) {
-                int argValue;
-                cin >> argValue;
-                currentCmd.parameters.push_back(argValue);
-            }
+    // demand paging: the frame table, the replacement policy and the page file
+    if (!demandPolicy.empty()) {
+        int frames = maxMemory >> pageShift;
+        if (frames <= FAULT_RESERVE_FRAMES) {
+            cerr << "Demand paging needs at least " << (FAULT_RESERVE_FRAMES + 1) << " frames" << endl;
+            return 1;
+        }
+        frameRow.assign(frames, -1);
+        framePage.assign(frames, 0);
+        frameDirty.assign(frames, 0);
+        framePinned.assign(frames, 0);
+        frameLocked.assign(frames, 0);
+        pageReplacer = createReplacer(demandPolicy, frames);
+        pageFile.open(pageFileName.c_str(), ios::in | ios::out | ios::binary | ios::trunc);
+        if (!pageFile) {
+            cerr << "Cannot open page file " << pageFileName << endl;
+            return 1;
+        }
+    }
 
-            // add this instruction to the process
-            process.instructions.push_back(currentCmd);
+    // start the allocation trace with its header
+    if (!traceFileName.empty()) {
+        traceFile.open(traceFileName.c_str(), ios::out | ios::binary | ios::trunc);
+        if (!traceFile) {
+            cerr << "Cannot open trace file " << traceFileName << endl;
+            return 1;
         }
+        traceFile.write("P3AT", 4);
+        traceFile.write(reinterpret_cast<const char*>(&TRACE_VERSION), sizeof(TRACE_VERSION));
+        traceFile.write(reinterpret_cast<const char*>(&maxMemory), sizeof(maxMemory));
+    }
 
-        // add this process to the new job queue
-        newJobQueue.push(process);
+    // start the fragmentation time series with its header row
+    if (!fragmentationFileName.empty()) {
+        fragmentationFile.open(fragmentationFileName.c_str(), ios::out | ios::trunc);
+        if (!fragmentationFile) {
+            cerr << "Cannot open fragmentation file " << fragmentationFileName << endl;
+            return 1;
+        }
+        fragmentationTracker.init(maxMemory);
+        fragmentationFile << "time,free_words,largest_free_block,holes,peak_holes,external_fragmentation";
+        for (size_t k = 0; k < fragmentationTracker.histogram.size(); k++) {
+            fragmentationFile << ",holes_" << (1 << k);
+        }
+        fragmentationFile << '\n';
     }
 
+    // read data for each process (in streaming mode only the first few)
+    processesToRead = numProcesses;
+    readJobsFromInput(newJobQueue);
+
     // attempt to load initial jobs into memory
     loadJobsToMemory(newJobQueue, readyQueue, mainMemory);
 
-    // print the initial state of memory
+    // print the initial state of memory (stale words get their -1 first)
+    materializeWords(mainMemory, 0, maxMemory);
     for (int i = 0; i < maxMemory; i++) {
         cout << i << " : " << mainMemory[i] << endl;
     }
 
     // main execution loop
     // continue as long as there are processes in any queue
-    while (!readyQueue.empty() || !ioWaitingQueue.empty() || !newJobQueue.empty()) {
+    while (!readyQueue.empty() || !ioWaitingQueue.empty() || !newJobQueue.empty() ||
+           !futureArrivals.empty() || processesToRead > 0) {
+        // let in any jobs whose arrival time has come
+        readJobsFromInput(newJobQueue);
+        if (releaseArrivedJobs(newJobQueue) > 0) {
+            loadJobsToMemory(newJobQueue, readyQueue, mainMemory);
+        }
+
         if (!readyQueue.empty()) {
             // if there are processes ready to run
+            finishIdleMove(mainMemory, readyQueue);
             
             // get the next process to execute
-            int startAddress = readyQueue.front();
-            readyQueue.pop();
+            int startAddress = selectNextProcess(readyQueue);
             
             // execute this process
             executeCPU(startAddress, mainMemory, newJobQueue, readyQueue);
@@ -742,12 +6096,26 @@ int main() {
             // advance the clock by context switch time
             // this simulates the cpu being idle while waiting for IO
             globalClock += contextSwitchTime;
+            
+            // let the background defragmenter use the idle time
+            if (idleCompactBudget > 0) {
+                idleCompact(mainMemory, readyQueue, idleCompactBudget * max(1, contextSwitchTime));
+            }
         }
-        else {
+        else if (!newJobQueue.empty()) {
             // if there are only new jobs waiting for memory
             // advance the clock by context switch time
             // this simulates the cpu being idle while waiting for memory to become available
             globalClock += contextSwitchTime;
+            
+            // let the background defragmenter use the idle time
+            if (idleCompactBudget > 0) {
+                idleCompact(mainMemory, readyQueue, idleCompactBudget * max(1, contextSwitchTime));
+            }
+        }
+        else {
+            // nothing is in the system yet, skip ahead to the next arrival
+            globalClock = max(globalClock, futureArrivals.begin()->first);
         }
 
         // always check if any IO operations have completed
@@ -762,10 +6130,102 @@ int main() {
     // print the total CPU time used by all processes
     cout << "Total CPU time used: " << globalClock << "." << endl;
 
+    // close the fragmentation time series at the final time
+    if (fragmentationFile.is_open()) {
+        sampleFragmentation(globalClock);
+    }
+
+    // print the deadline report if deadlines were given
+    if (readDeadlines) {
+        printDeadlineReport();
+    }
+
+    // print the scheduling report for the adaptive quantum or
+    // tiered switch costs (or on request)
+    if (adaptiveQuantum || tieredSwitchCost || printStats) {
+        printSchedulingReport();
+    }
+
+    // print the admission report for backfilling, swapping, compaction, lazy
+    // scrubbing or the placement check (or on request)
+    if (backfillAdmission || swappingEnabled || compactionEnabled || idleCompactBudget > 0 ||
+        lazyScrub || placementCheck || printStats) {
+        printAdmissionReport(maxMemory);
+    }
+
+    // print the arrival report when jobs arrived over time
+    if (arrivalMode != "none") {
+        printArrivalReport();
+    }
+
+    // print the paging report in paged mode
+    if (pageSize > 0) {
+        printPagingReport(maxMemory);
+    }
+
+    // print the segment report in segmented mode
+    if (segmentedMemory) {
+        printSegmentReport(maxMemory);
+    }
+
+    // print the TLB report when there is a TLB
+    if (tlbEntries > 0) {
+        printTLBReport();
+    }
+
+    // print the demand paging report with demand paging
+    if (pageReplacer != NULL) {
+        printDemandPagingReport();
+    }
+
+    // print the fork report if any process executed a FORK
+    if (forkStats.forks + forkStats.failures > 0) {
+        printForkReport();
+    }
+
+    // print the swap report when the swapper was on
+    if (swappingEnabled) {
+        printSwapReport();
+    }
+
+    // print the allocator's own counters for the buddy allocator (or on request)
+    if (allocatorName == "buddy" || printStats) {
+        memoryAllocator->printStatistics();
+    }
+
+    // the default swap file is scratch space; one named on the command line is kept
+    if (swapFile.is_open()) {
+        swapFile.close();
+        if (!keepSwapFile) {
+            remove(swapFileName.c_str());
+        }
+    }
+
+    // and so is the default page file
+    if (pageFile.is_open()) {
+        pageFile.close();
+        if (!keepPageFile) {
+            remove(pageFileName.c_str());
+        }
+    }
+
     return 0;
 }
 /*
 g++ -o CS3113_Project3 CS3113_Project3.cpp
 ./CS3113_Project3 < sampleInput1.txt
 ./CS3113_Project3 < sampleInput1.txt > output.txt
+./CS3113_Project3 --scheduler=edf < input.txt   (process records carry deadlines, see main)
+./CS3113_Project3 --arrivals=poisson:20 --stats < sampleInput1.txt
+./CS3113_Project3 --bench=placement
+./CS3113_Project3 --bench=first-fit,bitmap --bench-memory=1048576,16777216,268435456
+./CS3113_Project3 --scrub=lazy --stats < sampleInput1.txt
+./CS3113_Project3 --trace-out=run.trace < sampleInput1.txt
+./CS3113_Project3 --bench=first-fit,tlsf,buddy --bench-trace=run.trace
+./CS3113_Project3 --paging=64 --stats < sampleInput1.txt
+./CS3113_Project3 --paging=64 --tlb=16 --tlb-ways=4 --tlb-asid < sampleInput1.txt
+./CS3113_Project3 --paging=16 --demand-paging=clock --fault-time=20 < sampleInput1.txt
+./CS3113_Project3 --paging=16 --demand-paging=lru --load-control --ws-window=32 < sampleInput1.txt
+./CS3113_Project3 --segments --stats < sampleInput1.txt
+./CS3113_Project3 --quantum=adaptive --quantum-min=5 --quantum-max=50 < sampleInput1.txt
 */
\ No newline at end of file